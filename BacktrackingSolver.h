@@ -5,49 +5,113 @@
 #ifndef BACKTRACKINGSOLVER_H
 #define BACKTRACKINGSOLVER_H
 
-#include <unordered_map>
-#include <unordered_set>
+#include <array>
+#include <cstdint>
+#include <memory>
 
+#include "BoardShape.h"
+#include "SolveStats.h"
 #include "SudokuBoard.h"
 #include "SudokuSolver.h"
 #include "Timer.h"
 
-class BacktrackingSolver : public SudokuSolver {
+/**
+ * plain backtracking: fill the empty cells in row major order, trying 1..9 in each, and go back when nothing fits.
+ * no heuristics on purpose, this is the baseline the other solvers are compared against.
+ *
+ * state is fixed size so solve() never allocates: which numbers each row/col/grid already holds is a 9-bit mask
+ * (bit n-1 set = number n used), and the recursion is an explicit stack holding the number placed in each empty cell.
+ * every placement is a guess here, so nodes == guesses in the stats.
+ */
+template <typename Stats = NoStats>
+class BasicBacktrackingSolver : public SudokuSolver {
+
+    static constexpr uint16_t ALL_NUMBERS = 0x1FF;
+
+    std::array<uint16_t, 9> rowMask, colMask, gridMask;
+    // cells to fill, in the order they are filled, and how many there are
+    std::array<uint8_t, 81> emptyCells;
+    int emptyCount;
+    // stack[k] = number currently placed in emptyCells[k], 0 if none yet
+    std::array<uint8_t, 81> stack;
+    // solutions found so far, and how many to find before stopping (1 when solving)
+    long long solutionCount, solutionLimit;
+    Stats stats;
+
+    /**
+     * records the clues of the board in the masks and backtracks until `limit` solutions are found.
+     * TC: O(9^(number of empty cells)) worst case, like any plain backtracking
+     * @param board board to fill. holds the last solution found if `limit` solutions were found, otherwise the clues.
+     * @param limit
+     * @return number of solutions found, at most `limit`. 0 if two clues clash.
+     */
+    long long search(Grid &board, long long limit) {
+        resourceClear();
 
-    std::unordered_map<int, std::unordered_set<char>> rowset, colset;
-    std::unordered_map<int, std::unordered_map<int, std::unordered_set<char>>> gridset;
-    bool found;  // Flag to indicate whether a solution has been found
-    long long cnt;
+        // Record the current state of the board
+        for (int cell = 0; cell < 81; cell++) {
+            uint8_t num = board[cell];
+            if (num == 0) {
+                emptyCells[emptyCount++] = (uint8_t) cell;
+            } else {
+                if (!isRight(cell, num)) return 0; // same number twice in a row/col/grid
+                insert(cell, num);
+            }
+        }
 
-public:
-    BacktrackingSolver() : SudokuSolver(), found(false), cnt(0) {
+        solutionLimit = limit;
+        int k = 0;  // index into emptyCells of the cell being filled
+        if (emptyCount > 0) stack[0] = 0;
+        while (k >= 0) {
+            if (k == emptyCount) {  // Solution found
+                if (++solutionCount >= solutionLimit) break;  // the board keeps the solution
+                k--;  // otherwise keep looking, starting from the last cell
+                continue;
+            }
+
+            int cell = emptyCells[k];
+            uint8_t n = stack[k];
+            if (n != 0) {  // take back the number tried before
+                stats.backtrack();
+                erase(cell, n);
+                board[cell] = 0;
+            }
+
+            // smallest number bigger than n that fits
+            uint16_t fits = ~used(cell) & (ALL_NUMBERS << n) & ALL_NUMBERS;
+            if (fits == 0) {  // nothing left for this cell, go back
+                stack[k] = 0;
+                k--;
+                continue;
+            }
+
+            n = (uint8_t) (__builtin_ctz(fits) + 1);
+            stats.node(k + 1);
+            stats.guess();
+            insert(cell, n);
+            board[cell] = n;
+            stack[k++] = n;
+            if (k < emptyCount) stack[k] = 0;
+        }
+        return solutionCount;
     }
 
-    virtual void solve(SudokuBoard &sb) override {
+public:
+    BasicBacktrackingSolver() : SudokuSolver() {
         resourceClear();
+    }
 
+    virtual void solve(SudokuBoard &sb) override {
         Timer t;
-        std::vector<std::vector<char>> board = sb.getOriginalBoard();
+        Grid board = sb.getOriginalGrid();
 
-        // Record the current state of the board
-        for (int i = 0; i < 9; i++) {
-            for (int j = 0; j < 9; j++) {
-                if (board[i][j] != '.') {
-                    rowset[i].insert(board[i][j]);
-                    colset[j].insert(board[i][j]);
-                    gridset[i/3][j/3].insert(board[i][j]);
-                }
-            }
-        }
-        // Start backtracking
-        found = false;
-        backtrack(board, 0);
-        if (found) { // if there was solution,
+        if (search(board, 1) == 1) { // if there was solution,
             // record time
             sb.setElapsedTime(t.end());
             // save answer
-            sb.setSolvedBoard(std::move(board));
+            sb.setSolvedGrid(board);
             sb.setAlgorithmUsed("basic backtracking");
+            if constexpr (Stats::enabled) sb.setStats(stats.get());
         }
         else {
             // if couldn't solve the board, the board configuration was wrong, so we need to get another board.
@@ -56,67 +120,51 @@ public:
         }
     }
 
-    virtual void resourceClear() override {
-        rowset.clear(), colset.clear(), gridset.clear();
+    virtual long long countSolutions(const SudokuBoard &sb, long long limit = 2) override {
+        Grid board = sb.getOriginalGrid();
+        return search(board, limit);
     }
 
-    void backtrack(std::vector<std::vector<char>>& board, int p) {
-        // cnt++;
-
-        int row = p / 9;
-        int col = p % 9;
-
-        if (p == 81) {  // Solution found
-            found = true;
-            return;
-        }
-
-        if (board[row][col] != '.') {  // Skip pre-filled cells
-            backtrack(board, p + 1);
-            return;
-        }
-
-        for (int i = 0; i < 9; i++) {
-            char c = '1' + i;
-            if (isRight(row, col, c)) {
-                insert(row, col, c);
-                board[row][col] = c;
-
-                backtrack(board, p + 1);
-
-                if (found) return;  // Early termination within the loop
-
-                erase(row, col, c);
-                board[row][col] = '.';
-            }
-        }
+    virtual std::unique_ptr<SudokuSolver> clone() const override {
+        return std::make_unique<BasicBacktrackingSolver>();
+    }
 
+    virtual void resourceClear() override {
+        rowMask.fill(0), colMask.fill(0), gridMask.fill(0);
+        emptyCount = 0;
+        solutionCount = 0;
+        solutionLimit = 1;
+        stats.clear();
     }
 
-    bool isRight(const int &row, const int &col, const char &x) {
-        // Check if the character is already present in the row, column, or gridset
-        if (rowset[row].find(x) != rowset[row].end())
-            return false;
-        if (colset[col].find(x) != colset[col].end())
-            return false;
-        if (gridset[row/3][col/3].find(x) != gridset[row/3][col/3].end())
-            return false;
+    // numbers already in the row, col and grid of the cell
+    uint16_t used(int cell) const {
+        return rowMask[Board9::rowOf(cell)] | colMask[Board9::colOf(cell)] | gridMask[Board9::boxOf(cell)];
+    }
 
-        return true;
+    bool isRight(int cell, uint8_t x) const {
+        // Check if the number is already present in the row, column, or grid
+        uint16_t bit = 1 << (x - 1);
+        return !(used(cell) & bit);
     }
 
-    void insert(const int &i, const int &j, const char &x) {
-        rowset[i].insert(x);
-        colset[j].insert(x);
-        gridset[i/3][j/3].insert(x);
+    void insert(int cell, uint8_t x) {
+        uint16_t bit = 1 << (x - 1);
+        rowMask[Board9::rowOf(cell)] |= bit;
+        colMask[Board9::colOf(cell)] |= bit;
+        gridMask[Board9::boxOf(cell)] |= bit;
     }
 
-    void erase(const int &i, const int &j, const char &x) {
-        rowset[i].erase(x);
-        colset[j].erase(x);
-        gridset[i/3][j/3].erase(x);
+    void erase(int cell, uint8_t x) {
+        uint16_t bit = ~(1 << (x - 1));
+        rowMask[Board9::rowOf(cell)] &= bit;
+        colMask[Board9::colOf(cell)] &= bit;
+        gridMask[Board9::boxOf(cell)] &= bit;
     }
 
 };
 
+using BacktrackingSolver = BasicBacktrackingSolver<>;
+using BacktrackingSolverWithStats = BasicBacktrackingSolver<CollectStats>;
+
 #endif //BACKTRACKINGSOLVER_H
@@ -0,0 +1,143 @@
+//
+// Compile-time geometry of a sudoku board with BOX x BOX boxes (4x4 up to 25x25).
+//
+
+#ifndef BOARDSHAPE_H
+#define BOARDSHAPE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * everything about the layout of an N x N board (N = BOX*BOX) that solvers would otherwise recompute with divisions:
+ * row/col/box of every cell, the 3 units of every cell, the cells of every unit, and the peers of every cell. The tables
+ * are built by constexpr functions, so each size gets its own constant tables and the solver code templated on it has
+ * no runtime size at all.
+ *
+ * units are numbered rows 0..N-1, cols N..2N-1, boxes 2N..3N-1 (the same order as HeuristicsBacktrackingSolver uses).
+ * numbers on the board are 1..N, 0 is empty. a set of numbers is a Mask with bit n-1 set for number n.
+ */
+template <int BOX>
+struct BoardShape {
+    static_assert(BOX >= 2 && BOX <= 5, "boards from 4x4 (BOX=2) to 25x25 (BOX=5)");
+
+    static constexpr int N = BOX * BOX;
+    static constexpr int CELLS = N * N;
+    static constexpr int UNITS = 3 * N;
+    // cells sharing a row, col or box with a cell (20 on a 9x9 board)
+    static constexpr int PEERS = 3 * (N - 1) - 2 * (BOX - 1);
+
+    // smallest type holding one bit per number, and one holding a cell index
+    using Mask = std::conditional_t<N <= 16, uint16_t, uint32_t>;
+    using Index = std::conditional_t<CELLS <= 256, uint8_t, uint16_t>;
+    using Grid = std::array<uint8_t, CELLS>;
+
+    static constexpr Mask ALL = (Mask) ((1ull << N) - 1);
+
+    struct Tables {
+        std::array<uint8_t, CELLS> row{}, col{}, box{};
+        std::array<std::array<uint8_t, 3>, CELLS> cellUnits{};  // row, col and box unit of each cell
+        std::array<std::array<Index, N>, UNITS> units{};
+        std::array<std::array<Index, PEERS>, CELLS> peers{};
+    };
+
+    static constexpr Tables build() {
+        Tables t{};
+        std::array<int, UNITS> filled{};
+        for (int cell = 0; cell < CELLS; cell++) {
+            int r = cell / N, c = cell % N, b = r / BOX * BOX + c / BOX;
+            t.row[cell] = (uint8_t) r;
+            t.col[cell] = (uint8_t) c;
+            t.box[cell] = (uint8_t) b;
+            t.cellUnits[cell] = {(uint8_t) r, (uint8_t) (N + c), (uint8_t) (2 * N + b)};
+            t.units[r][filled[r]++] = (Index) cell;
+            t.units[N + c][filled[N + c]++] = (Index) cell;
+            t.units[2 * N + b][filled[2 * N + b]++] = (Index) cell;
+        }
+        // the rest of the row, the rest of the col, and the box cells on neither
+        // (walking the 3 units instead of all cells keeps 25x25 within the compiler's constexpr budget)
+        for (int cell = 0; cell < CELLS; cell++) {
+            int count = 0;
+            for (int other : t.units[t.row[cell]]) {
+                if (other != cell) t.peers[cell][count++] = (Index) other;
+            }
+            for (int other : t.units[N + t.col[cell]]) {
+                if (other != cell) t.peers[cell][count++] = (Index) other;
+            }
+            for (int other : t.units[2 * N + t.box[cell]]) {
+                if (t.row[other] != t.row[cell] && t.col[other] != t.col[cell]) t.peers[cell][count++] = (Index) other;
+            }
+        }
+        return t;
+    }
+
+    static constexpr Tables tables = build();
+
+    static constexpr int rowOf(const int &cell) { return tables.row[cell]; }
+    static constexpr int colOf(const int &cell) { return tables.col[cell]; }
+    static constexpr int boxOf(const int &cell) { return tables.box[cell]; }
+    static constexpr const std::array<uint8_t, 3>& unitsOf(const int &cell) { return tables.cellUnits[cell]; }
+    static constexpr const std::array<Index, N>& unitCells(const int &unit) { return tables.units[unit]; }
+    static constexpr const std::array<Index, PEERS>& peersOf(const int &cell) { return tables.peers[cell]; }
+
+    // text format: '1'-'9' then 'A'.. for 10.. (so 'G' is 16 and 'P' is 25), '.' or '0' for empty. -1 if not a cell.
+    static int charToNumber(const char &c) {
+        int n = -1;
+        if (c == '.' || c == '0') n = 0;
+        else if (c >= '1' && c <= '9') n = c - '0';
+        else if (c >= 'A' && c <= 'Z') n = c - 'A' + 10;
+        else if (c >= 'a' && c <= 'z') n = c - 'a' + 10;
+        return n <= N ? n : -1;
+    }
+    static char numberToChar(const int &n) {
+        return n == 0 ? '.' : n <= 9 ? (char) ('0' + n) : (char) ('A' + n - 10);
+    }
+
+    /**
+     * parses one board in row major order, CELLS characters. anything after that is ignored.
+     * @return false if the line is too short or has a character that is not a number of this size.
+     */
+    static bool fromString(const char *s, size_t len, Grid &out) {
+        if (len < (size_t) CELLS) return false;
+        for (int i = 0; i < CELLS; i++) {
+            int n = charToNumber(s[i]);
+            if (n < 0) return false;
+            out[i] = (uint8_t) n;
+        }
+        return true;
+    }
+    // writes CELLS characters to `out`, '.' for empty.
+    static void toString(const Grid &grid, char *out) {
+        for (int i = 0; i < CELLS; i++) out[i] = numberToChar(grid[i]);
+    }
+
+    // FNV-1a over the cells, for hash maps keyed by a grid (e.g. LruCache<Grid, ..., Hash>)
+    struct Hash {
+        size_t operator()(const Grid &grid) const {
+            uint64_t h = 14695981039346656037ull;
+            for (uint8_t n : grid) h = (h ^ n) * 1099511628211ull;
+            return (size_t) h;
+        }
+    };
+
+    // true if `solution` is a full valid board that keeps every clue of `puzzle`.
+    static bool isValidSolution(const Grid &puzzle, const Grid &solution) {
+        for (int i = 0; i < CELLS; i++) {
+            if (solution[i] < 1 || solution[i] > N) return false;
+            if (puzzle[i] != 0 && puzzle[i] != solution[i]) return false;
+        }
+        for (int u = 0; u < UNITS; u++) {
+            Mask seen = 0;
+            for (int cell : unitCells(u)) seen |= (Mask) (1u << (solution[cell] - 1));
+            if (seen != ALL) return false;
+        }
+        return true;
+    }
+};
+
+// the classic 9x9 board, shared by all the SudokuSolvers
+using Board9 = BoardShape<3>;
+
+#endif //BOARDSHAPE_H
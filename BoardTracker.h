@@ -0,0 +1,167 @@
+//
+// Follows a detected board from frame to frame with optical flow, so the full contour detection only runs to find it.
+//
+
+#ifndef BOARDTRACKER_H
+#define BOARDTRACKER_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+/**
+ * once a board is detected, lock() picks trackable points on it (its 4 corners plus the strongest grid corners
+ * inside it) and remembers where they were. every track() then:
+ *   - moves the points into the new frame with pyramidal Lucas-Kanade, and back again. points that don't come back
+ *     to where they were (occluded, blurred, slid along an edge) are dropped.
+ *   - fits one homography from the points' positions at lock time to their new positions (RANSAC). a flat board moves
+ *     as one homography, so points that disagree with it are dropped too.
+ *   - maps the corners from lock time through it. many points average out the pixel noise of each one, so the corners
+ *     don't jitter like a fresh approxPolyDP every frame does, and mapping from lock time doesn't drift.
+ * confidence is the fraction of the lock time points still agreeing. when it drops too low, or the board doesn't look
+ * like a board any more, track() fails and unlocks, and the caller goes back to the full detection.
+ * points are lost a few at a time even on a good lock (a hand over the board, motion blur), so once fewer than
+ * RESEED_BELOW of them are left, new grid corners are picked inside the tracked board, away from the surviving points,
+ * and mapped back to lock time coordinates through the inverse homography. a long lock keeps its point count.
+ */
+class BoardTracker {
+public:
+    static constexpr int MAX_POINTS = 60;            // grid corners picked inside the board
+    static constexpr int MIN_POINTS = 8;             // fewer agreeing points than this and the homography is a guess
+    static constexpr float MIN_CONFIDENCE = 0.4f;    // of the lock time points
+    static constexpr float RESEED_BELOW = 0.7f;      // of the lock time points
+    static constexpr float MAX_BACK_ERROR = 1.0f;    // pixels a point may miss its start by, tracked forth and back
+    static constexpr double RANSAC_THRESHOLD = 3.0;  // pixels
+
+    bool locked() const {
+        return !reference.empty();
+    }
+    float getConfidence() const {
+        return confidence;
+    }
+
+    void reset() {
+        reference.clear();
+        current.clear();
+        prevGray.release();
+        confidence = 0;
+    }
+
+    /**
+     * starts tracking a board found by the full detection.
+     * @param gray the frame the board was found in, 8-bit gray. kept until the next track(), don't write into it.
+     * @param corners top left, top right, bottom right, bottom left
+     * @return false if the board has too few trackable points (stays unlocked)
+     */
+    bool lock(const cv::Mat &gray, const std::vector<cv::Point> &corners) {
+        reset();
+        cv::Mat mask = cv::Mat::zeros(gray.rows, gray.cols, CV_8UC1);
+        cv::fillConvexPoly(mask, corners, cv::Scalar(255));
+        std::vector<cv::Point2f> points;
+        const double side = std::sqrt(std::fabs(cv::contourArea(corners)));
+        spacing = std::max(5.0, side / 30);
+        cv::goodFeaturesToTrack(gray, points, MAX_POINTS, 0.01, spacing, mask);
+        for (const cv::Point &c : corners) points.emplace_back(c);
+        if ((int) points.size() < MIN_POINTS + 4) return false;
+
+        reference = points;
+        current = points;
+        referenceCorners.assign(corners.begin(), corners.end());
+        lockedPoints = (int) points.size();
+        lockedArea = std::fabs(cv::contourArea(corners));
+        prevGray = gray;
+        confidence = 1;
+        return true;
+    }
+
+    /**
+     * follows the board into the next frame.
+     * @param gray the next frame, 8-bit gray, same size. kept until the next track(), don't write into it.
+     * @param corners out: the board corners in this frame, same order as lock()
+     * @return false if the board is lost. the tracker is then unlocked: run the full detection and lock() again.
+     */
+    bool track(const cv::Mat &gray, std::vector<cv::Point> &corners) {
+        if (!locked()) return false;
+        std::vector<cv::Point2f> next, back;
+        std::vector<uchar> status, backStatus;
+        std::vector<float> error;
+        const cv::Size window(21, 21);
+        cv::calcOpticalFlowPyrLK(prevGray, gray, current, next, status, error, window, 3);
+        cv::calcOpticalFlowPyrLK(gray, prevGray, next, back, backStatus, error, window, 3);
+
+        std::vector<cv::Point2f> from, to;
+        for (size_t i = 0; i < current.size(); i++) {
+            if (!status[i] || !backStatus[i]) continue;
+            cv::Point2f miss = back[i] - current[i];
+            if (miss.x * miss.x + miss.y * miss.y > MAX_BACK_ERROR * MAX_BACK_ERROR) continue;
+            from.push_back(reference[i]);
+            to.push_back(next[i]);
+        }
+        if ((int) from.size() < MIN_POINTS) return lose();
+
+        std::vector<uchar> inliers;
+        cv::Mat homography = cv::findHomography(from, to, cv::RANSAC, RANSAC_THRESHOLD, inliers);
+        if (homography.empty()) return lose();
+        reference.clear();
+        current.clear();
+        for (size_t i = 0; i < from.size(); i++) {
+            if (!inliers[i]) continue;
+            reference.push_back(from[i]);
+            current.push_back(to[i]);
+        }
+        confidence = (float) reference.size() / lockedPoints;
+        if ((int) reference.size() < MIN_POINTS || confidence < MIN_CONFIDENCE) return lose();
+
+        std::vector<cv::Point2f> quad;
+        cv::perspectiveTransform(referenceCorners, quad, homography);
+        std::vector<cv::Point> moved(quad.begin(), quad.end());
+        if (!plausible(moved)) return lose();
+
+        if (reference.size() < lockedPoints * RESEED_BELOW) reseed(gray, moved, homography);
+        corners = moved;
+        prevGray = gray;
+        return true;
+    }
+
+private:
+    std::vector<cv::Point2f> reference;         // tracked points where they were at lock time
+    std::vector<cv::Point2f> current;           // the same points in the last frame
+    std::vector<cv::Point2f> referenceCorners;  // board corners at lock time
+    cv::Mat prevGray;
+    int lockedPoints = 0;
+    double lockedArea = 0;
+    double spacing = 5;  // min distance between picked points, from the board size at lock time
+    float confidence = 0;
+
+    bool lose() {
+        reset();
+        return false;
+    }
+
+    /**
+     * tops the points back up to the lock time count with new grid corners inside `quad` in this frame.
+     * @param homography lock time -> this frame, as fitted by track()
+     */
+    void reseed(const cv::Mat &gray, const std::vector<cv::Point> &quad, const cv::Mat &homography) {
+        cv::Mat mask = cv::Mat::zeros(gray.rows, gray.cols, CV_8UC1);
+        cv::fillConvexPoly(mask, quad, cv::Scalar(255));
+        for (const cv::Point2f &p : current) cv::circle(mask, p, (int) spacing, cv::Scalar(0), -1);
+        std::vector<cv::Point2f> fresh, atLock;
+        cv::goodFeaturesToTrack(gray, fresh, lockedPoints - (int) current.size(), 0.01, spacing, mask);
+        if (fresh.empty()) return;
+        cv::perspectiveTransform(fresh, atLock, homography.inv());
+        reference.insert(reference.end(), atLock.begin(), atLock.end());
+        current.insert(current.end(), fresh.begin(), fresh.end());
+    }
+
+    // still a convex quad of about the size it was locked at (a homography fit to a few bad points can fold it)
+    bool plausible(const std::vector<cv::Point> &quad) const {
+        if (!cv::isContourConvex(quad)) return false;
+        const double area = std::fabs(cv::contourArea(quad));
+        return area > lockedArea / 3 && area < lockedArea * 3;
+    }
+};
+
+#endif //BOARDTRACKER_H
@@ -0,0 +1,305 @@
+//
+// Vectorized operations over the 81 candidate masks of a board, with runtime CPU dispatch.
+//
+
+#ifndef CANDIDATEKERNEL_H
+#define CANDIDATEKERNEL_H
+
+#include <array>
+#include <cstdint>
+
+#include "BoardShape.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CANDIDATE_KERNEL_X86 1
+#include <immintrin.h>
+#endif
+
+// set of cells 0-80, one bit per cell in two 64 bit words.
+struct CellSet {
+    std::array<uint64_t, 2> words{};
+
+    constexpr void set(const int &cell) { words[cell >> 6] |= 1ULL << (cell & 63); }
+    void reset(const int &cell) { words[cell >> 6] &= ~(1ULL << (cell & 63)); }
+    bool test(const int &cell) const { return (words[cell >> 6] >> (cell & 63)) & 1; }
+    bool empty() const { return (words[0] | words[1]) == 0; }
+    int count() const { return __builtin_popcountll(words[0]) + __builtin_popcountll(words[1]); }
+    // smallest cell in the set. the set must not be empty.
+    int lowest() const { return words[0] ? __builtin_ctzll(words[0]) : 64 + __builtin_ctzll(words[1]); }
+    // calls f(cell) for every cell in the set, in increasing order.
+    template <typename F>
+    void forEach(F f) const {
+        for (int w = 0; w < 2; w++) {
+            for (uint64_t bits = words[w]; bits; bits &= bits - 1)
+                f(w * 64 + __builtin_ctzll(bits));
+        }
+    }
+    CellSet operator&(const CellSet &o) const { CellSet s; s.words = {words[0] & o.words[0], words[1] & o.words[1]}; return s; }
+    CellSet operator|(const CellSet &o) const { CellSet s; s.words = {words[0] | o.words[0], words[1] | o.words[1]}; return s; }
+    bool operator==(const CellSet &o) const { return words == o.words; }
+    // removes every cell of `o` from this set
+    void remove(const CellSet &o) { words[0] &= ~o.words[0], words[1] &= ~o.words[1]; }
+    static CellSet all() {
+        CellSet s;
+        s.words = {~0ULL, (1ULL << (81 - 64)) - 1};
+        return s;
+    }
+};
+
+/**
+ * The 81 candidate masks (bit n-1 set = number n possible) fit in 81 * 16 bits, i.e. 6 AVX2 or 12 SSE registers
+ * once padded to 96 lanes. Instead of the scalar loops over cells and peers, the kernel does:
+ *   - scan:        one pass that finds every cell with exactly one candidate (naked single) and every cell with none.
+ *   - eliminate:   removes a number from the 20 peers of a cell, returning which peers actually lost it.
+ *   - unitUnions:  OR of the candidate masks of each of the 27 units (9 rows, 9 cols, 9 grids).
+ *
+ * Masks must be stored in an array of LANES uint16_t whose padding lanes 81..95 are 0.
+ * best() picks the widest implementation the CPU supports, once. scalar() is the portable fallback.
+ */
+class CandidateKernel {
+public:
+    static constexpr int CELLS = 81;
+    static constexpr int LANES = 96;
+
+    // result of scan(): cells with exactly one candidate, and cells with no candidate (filled cells included).
+    struct Scan {
+        CellSet singles;
+        CellSet zeros;
+    };
+
+    using ScanFn = Scan (*)(const uint16_t *masks);
+    using EliminateFn = CellSet (*)(uint16_t *masks, int cell, uint16_t bit);
+    using UnitUnionsFn = void (*)(const uint16_t *masks, uint16_t *unions);
+
+    const char *name;
+    ScanFn scan;
+    EliminateFn eliminate;
+    // writes 27 masks: unions[0..8] rows, unions[9..17] cols, unions[18..26] grids.
+    UnitUnionsFn unitUnions;
+
+    static const CandidateKernel& scalar() {
+        static const CandidateKernel k{"scalar", scanScalar, eliminateScalar, unitUnionsScalar};
+        return k;
+    }
+
+#ifdef CANDIDATE_KERNEL_X86
+    static const CandidateKernel& sse2() {
+        static const CandidateKernel k{"sse2", scanSSE2, eliminateSSE2, unitUnionsScalar};
+        return k;
+    }
+    static const CandidateKernel& avx2() {
+        static const CandidateKernel k{"avx2", scanAVX2, eliminateAVX2, unitUnionsAVX2};
+        return k;
+    }
+#endif
+
+    // the fastest kernel this CPU can run. decided on first call.
+    static const CandidateKernel& best() {
+        static const CandidateKernel &k = detect();
+        return k;
+    }
+
+private:
+    // lanes[cell][i] is 0xFFFF if cell i is a peer of `cell` (same row, col or grid, not the cell itself).
+    struct PeerLanes {
+        uint16_t lanes[CELLS][LANES];
+    };
+
+    static constexpr PeerLanes makePeerLanes() {
+        PeerLanes t{};
+        for (int cell = 0; cell < CELLS; cell++) {
+            for (int peer : Board9::peersOf(cell)) t.lanes[cell][peer] = 0xFFFF;
+        }
+        return t;
+    }
+
+    static const PeerLanes& peerLanes() {
+        alignas(32) static constexpr PeerLanes table = makePeerLanes();
+        return table;
+    }
+
+    static const CandidateKernel& detect() {
+#ifdef CANDIDATE_KERNEL_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return avx2();
+        if (__builtin_cpu_supports("sse2")) return sse2();
+#endif
+        return scalar();
+    }
+
+    // ---- scalar ----
+
+    static Scan scanScalar(const uint16_t *masks) {
+        Scan s;
+        for (int i = 0; i < CELLS; i++) {
+            uint16_t m = masks[i];
+            if (m == 0) s.zeros.set(i);
+            else if ((m & (m - 1)) == 0) s.singles.set(i);
+        }
+        return s;
+    }
+
+    static CellSet eliminateScalar(uint16_t *masks, int cell, uint16_t bit) {
+        CellSet changed;
+        const uint16_t *peers = peerLanes().lanes[cell];
+        for (int i = 0; i < CELLS; i++) {
+            if (masks[i] & peers[i] & bit) {
+                masks[i] &= ~bit;
+                changed.set(i);
+            }
+        }
+        return changed;
+    }
+
+    static void unitUnionsScalar(const uint16_t *masks, uint16_t *unions) {
+        for (int u = 0; u < 27; u++) unions[u] = 0;
+        for (int i = 0; i < CELLS; i++) {
+            for (int u : Board9::unitsOf(i)) unions[u] |= masks[i];
+        }
+    }
+
+#ifdef CANDIDATE_KERNEL_X86
+    // cells 81..95 are padding
+    static CellSet fromBits(uint64_t lo, uint64_t hi) {
+        CellSet s;
+        s.words = {lo, hi & ((1ULL << (CELLS - 64)) - 1)};
+        return s;
+    }
+
+    // ---- SSE2: 12 registers of 8 lanes ----
+
+    // one bit per lane of two 8-lane compare results (all ones / all zeros per lane)
+    __attribute__((target("sse2")))
+    static uint64_t laneBitsSSE2(__m128i a, __m128i b) {
+        return (uint32_t) _mm_movemask_epi8(_mm_packs_epi16(a, b));
+    }
+
+    __attribute__((target("sse2")))
+    static Scan scanSSE2(const uint16_t *masks) {
+        const __m128i zero = _mm_setzero_si128(), one = _mm_set1_epi16(1);
+        uint64_t singles[2] = {}, zeros[2] = {};
+        for (int v = 0; v < LANES / 8; v += 2) {
+            __m128i m0 = _mm_loadu_si128((const __m128i *) (masks + v * 8));
+            __m128i m1 = _mm_loadu_si128((const __m128i *) (masks + v * 8 + 8));
+            __m128i z0 = _mm_cmpeq_epi16(m0, zero), z1 = _mm_cmpeq_epi16(m1, zero);
+            // m & (m - 1) == 0 and m != 0
+            __m128i s0 = _mm_andnot_si128(z0, _mm_cmpeq_epi16(_mm_and_si128(m0, _mm_sub_epi16(m0, one)), zero));
+            __m128i s1 = _mm_andnot_si128(z1, _mm_cmpeq_epi16(_mm_and_si128(m1, _mm_sub_epi16(m1, one)), zero));
+            int base = v * 8;
+            singles[base >> 6] |= laneBitsSSE2(s0, s1) << (base & 63);
+            zeros[base >> 6] |= laneBitsSSE2(z0, z1) << (base & 63);
+        }
+        Scan s;
+        s.singles = fromBits(singles[0], singles[1]);
+        s.zeros = fromBits(zeros[0], zeros[1]);
+        return s;
+    }
+
+    __attribute__((target("sse2")))
+    static CellSet eliminateSSE2(uint16_t *masks, int cell, uint16_t bit) {
+        const uint16_t *peers = peerLanes().lanes[cell];
+        const __m128i b = _mm_set1_epi16((short) bit), zero = _mm_setzero_si128();
+        uint64_t changed[2] = {};
+        for (int v = 0; v < LANES / 8; v += 2) {
+            __m128i m0 = _mm_loadu_si128((const __m128i *) (masks + v * 8));
+            __m128i m1 = _mm_loadu_si128((const __m128i *) (masks + v * 8 + 8));
+            __m128i h0 = _mm_and_si128(_mm_and_si128(m0, b), _mm_loadu_si128((const __m128i *) (peers + v * 8)));
+            __m128i h1 = _mm_and_si128(_mm_and_si128(m1, b), _mm_loadu_si128((const __m128i *) (peers + v * 8 + 8)));
+            _mm_storeu_si128((__m128i *) (masks + v * 8), _mm_xor_si128(m0, h0));
+            _mm_storeu_si128((__m128i *) (masks + v * 8 + 8), _mm_xor_si128(m1, h1));
+            __m128i c0 = _mm_xor_si128(_mm_cmpeq_epi16(h0, zero), _mm_set1_epi16(-1));
+            __m128i c1 = _mm_xor_si128(_mm_cmpeq_epi16(h1, zero), _mm_set1_epi16(-1));
+            int base = v * 8;
+            changed[base >> 6] |= laneBitsSSE2(c0, c1) << (base & 63);
+        }
+        return fromBits(changed[0], changed[1]);
+    }
+
+    // ---- AVX2: 6 registers of 16 lanes ----
+
+    // one bit per lane of two 16-lane compare results. packs works per 128-bit half, so fix the order after it.
+    __attribute__((target("avx2")))
+    static uint64_t laneBitsAVX2(__m256i a, __m256i b) {
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), 0xD8);
+        return (uint32_t) _mm256_movemask_epi8(packed);
+    }
+
+    __attribute__((target("avx2")))
+    static Scan scanAVX2(const uint16_t *masks) {
+        const __m256i zero = _mm256_setzero_si256(), one = _mm256_set1_epi16(1);
+        uint64_t singles[2] = {}, zeros[2] = {};
+        for (int v = 0; v < LANES / 16; v += 2) {
+            __m256i m0 = _mm256_loadu_si256((const __m256i *) (masks + v * 16));
+            __m256i m1 = _mm256_loadu_si256((const __m256i *) (masks + v * 16 + 16));
+            __m256i z0 = _mm256_cmpeq_epi16(m0, zero), z1 = _mm256_cmpeq_epi16(m1, zero);
+            __m256i s0 = _mm256_andnot_si256(z0, _mm256_cmpeq_epi16(_mm256_and_si256(m0, _mm256_sub_epi16(m0, one)), zero));
+            __m256i s1 = _mm256_andnot_si256(z1, _mm256_cmpeq_epi16(_mm256_and_si256(m1, _mm256_sub_epi16(m1, one)), zero));
+            int base = v * 16; // 0, 32, 64: never straddles a word
+            singles[base >> 6] |= laneBitsAVX2(s0, s1) << (base & 63);
+            zeros[base >> 6] |= laneBitsAVX2(z0, z1) << (base & 63);
+        }
+        Scan s;
+        s.singles = fromBits(singles[0], singles[1]);
+        s.zeros = fromBits(zeros[0], zeros[1]);
+        return s;
+    }
+
+    __attribute__((target("avx2")))
+    static CellSet eliminateAVX2(uint16_t *masks, int cell, uint16_t bit) {
+        const uint16_t *peers = peerLanes().lanes[cell];
+        const __m256i b = _mm256_set1_epi16((short) bit), zero = _mm256_setzero_si256(), ones = _mm256_set1_epi16(-1);
+        uint64_t changed[2] = {};
+        for (int v = 0; v < LANES / 16; v += 2) {
+            __m256i m0 = _mm256_loadu_si256((const __m256i *) (masks + v * 16));
+            __m256i m1 = _mm256_loadu_si256((const __m256i *) (masks + v * 16 + 16));
+            __m256i h0 = _mm256_and_si256(_mm256_and_si256(m0, b), _mm256_loadu_si256((const __m256i *) (peers + v * 16)));
+            __m256i h1 = _mm256_and_si256(_mm256_and_si256(m1, b), _mm256_loadu_si256((const __m256i *) (peers + v * 16 + 16)));
+            _mm256_storeu_si256((__m256i *) (masks + v * 16), _mm256_xor_si256(m0, h0));
+            _mm256_storeu_si256((__m256i *) (masks + v * 16 + 16), _mm256_xor_si256(m1, h1));
+            __m256i c0 = _mm256_xor_si256(_mm256_cmpeq_epi16(h0, zero), ones);
+            __m256i c1 = _mm256_xor_si256(_mm256_cmpeq_epi16(h1, zero), ones);
+            int base = v * 16;
+            changed[base >> 6] |= laneBitsAVX2(c0, c1) << (base & 63);
+        }
+        return fromBits(changed[0], changed[1]);
+    }
+
+    // OR of lanes 0..7 of an SSE register into lane 0
+    __attribute__((target("avx2")))
+    static uint16_t horizontalOr8(__m128i x) {
+        x = _mm_or_si128(x, _mm_srli_si128(x, 8));
+        x = _mm_or_si128(x, _mm_srli_si128(x, 4));
+        x = _mm_or_si128(x, _mm_srli_si128(x, 2));
+        return (uint16_t) _mm_cvtsi128_si32(x);
+    }
+
+    __attribute__((target("avx2")))
+    static void unitUnionsAVX2(const uint16_t *masks, uint16_t *unions) {
+        // each row is 9 lanes starting at 9*row. 16-lane loads at those offsets stay inside the 96 lane array.
+        // OR of all rows gives the column unions in lanes 0..8; OR of the 3 rows of a band gives that band's
+        // per-column unions, which are folded by 3 into grid unions.
+        alignas(32) uint16_t band[3][16];
+        __m256i cols = _mm256_setzero_si256();
+        for (int b = 0; b < 3; b++) {
+            __m256i acc = _mm256_setzero_si256();
+            for (int r = b * 3; r < b * 3 + 3; r++) {
+                __m256i row = _mm256_loadu_si256((const __m256i *) (masks + r * 9));
+                acc = _mm256_or_si256(acc, row);
+                // lanes 0..7 of the row, plus lane 8 on its own
+                unions[r] = horizontalOr8(_mm256_castsi256_si128(row)) | masks[r * 9 + 8];
+            }
+            _mm256_store_si256((__m256i *) band[b], acc);
+            cols = _mm256_or_si256(cols, acc);
+        }
+        alignas(32) uint16_t colLanes[16];
+        _mm256_store_si256((__m256i *) colLanes, cols);
+        for (int c = 0; c < 9; c++) unions[9 + c] = colLanes[c];
+        for (int b = 0; b < 3; b++) {
+            for (int g = 0; g < 3; g++)
+                unions[18 + b * 3 + g] = band[b][g * 3] | band[b][g * 3 + 1] | band[b][g * 3 + 2];
+        }
+    }
+#endif
+};
+
+#endif //CANDIDATEKERNEL_H
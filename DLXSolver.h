@@ -0,0 +1,244 @@
+//
+// Dancing Links (Knuth's Algorithm X) solver.
+//
+
+#ifndef DLXSOLVER_H
+#define DLXSOLVER_H
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "BoardShape.h"
+#include "SolveStats.h"
+#include "SudokuBoard.h"
+#include "SudokuSolver.h"
+#include "Timer.h"
+
+/**
+ * Sudoku as an exact cover problem. Every (cell, number) pair is a row of the matrix (81*9 = 729 rows) and every
+ * constraint is a column (4*81 = 324 columns):
+ *   - cell constraint:       cell (r,c) holds some number          -> column   0 + r*9+c
+ *   - row constraint:        row r holds number n                  -> column  81 + r*9+n
+ *   - col constraint:        col c holds number n                  -> column 162 + c*9+n
+ *   - grid constraint:       grid g holds number n                 -> column 243 + g*9+n
+ * Each row has exactly 4 ones, so the matrix is stored as a toroidal doubly linked list of 729*4 nodes
+ * (Knuth, "Dancing Links"). Picking a row covers its 4 columns, and backtracking uncovers them in reverse order,
+ * so the matrix always returns to the state it was in.
+ *
+ * The node pool is built once in the constructor and reused for every board: solve() only relinks nodes.
+ * In the stats every row picked by search() is a guess: DLX has no propagation rules.
+ */
+template <typename Stats = NoStats>
+class BasicDLXSolver : public SudokuSolver {
+    static constexpr int COLS = 324;
+    static constexpr int ROWS = 729;
+    static constexpr int ROOT = 0;
+    // node 0 is the root, nodes 1..324 are column headers, the rest are the 4 nodes of each matrix row.
+    static constexpr int NODES = 1 + COLS + ROWS * 4;
+
+    // links of every node. C is the column header of a node, rowOf is the matrix row a node belongs to.
+    std::vector<int> L, R, U, D, C, rowOf;
+    // number of nodes left in each column
+    std::vector<int> S;
+    // whether column header is currently covered (used to detect clues contradicting each other)
+    std::vector<bool> covered;
+
+    // nodes of the matrix rows picked so far (clues first, then guesses). selected[0..depth) is the current partial solution.
+    std::array<int, 81> selected;
+    int depth;
+    // true once solutionLimit solutions are found. the search stops there.
+    bool found;
+    long long solutionCount, solutionLimit;
+    Stats stats;
+
+    static int rowIndex(int cell, int n) { return cell * 9 + n; }
+    // first node of matrix row `row` in the pool
+    static int rowStart(int row) { return 1 + COLS + row * 4; }
+
+    void cover(int c) {
+        covered[c] = true;
+        L[R[c]] = L[c];
+        R[L[c]] = R[c];
+        for (int i = D[c]; i != c; i = D[i]) {
+            for (int j = R[i]; j != i; j = R[j]) {
+                U[D[j]] = U[j];
+                D[U[j]] = D[j];
+                S[C[j]]--;
+            }
+        }
+    }
+
+    void uncover(int c) {
+        for (int i = U[c]; i != c; i = U[i]) {
+            for (int j = L[i]; j != i; j = L[j]) {
+                S[C[j]]++;
+                U[D[j]] = j;
+                D[U[j]] = j;
+            }
+        }
+        L[R[c]] = c;
+        R[L[c]] = c;
+        covered[c] = false;
+    }
+
+    // picks the matrix row that node `r` belongs to: covers every column of that row.
+    void selectRow(int r) {
+        selected[depth++] = r;
+        cover(C[r]);
+        for (int j = R[r]; j != r; j = R[j]) cover(C[j]);
+    }
+
+    // undoes selectRow(r).
+    void unselectRow(int r) {
+        for (int j = L[r]; j != r; j = L[j]) uncover(C[j]);
+        uncover(C[r]);
+        depth--;
+    }
+
+    /**
+     * Algorithm X: choose the column with the fewest nodes, try each row in it.
+     * Counts every solution and stops at the solutionLimit-th one, leaving its rows in selected[0..81).
+     * @param level number of guesses made so far
+     */
+    void search(const int &level) {
+        stats.node(level);
+        if (R[ROOT] == ROOT) { // every constraint satisfied
+            found = ++solutionCount >= solutionLimit;
+            return;
+        }
+
+        // choose column with least rows left (S heuristic)
+        int c = R[ROOT];
+        for (int j = R[c]; j != ROOT; j = R[j]) {
+            if (S[j] < S[c]) c = j;
+        }
+        if (S[c] == 0) return; // dead end
+
+        for (int r = D[c]; r != c; r = D[r]) {
+            stats.guess();
+            selectRow(r);
+            search(level + 1);
+            if (found) return;
+            stats.backtrack();
+            unselectRow(r);
+        }
+    }
+
+    /**
+     * selects the clue rows and runs Algorithm X until `limit` solutions are found.
+     * the matrix is left with the last solution found selected; resourceClear() restores it.
+     * @return number of solutions found, at most `limit`. 0 if two clues clash.
+     */
+    long long solveMatrix(const Grid &board, long long limit) {
+        resourceClear();
+
+        // clues are rows that are already part of the solution
+        for (int cell = 0; cell < 81; cell++) {
+            uint8_t num = board[cell];
+            if (num == 0) continue;
+            int first = rowStart(rowIndex(cell, num - 1));
+            for (int k = 0; k < 4; k++) {
+                if (covered[C[first + k]]) return 0; // two clues fight for the same constraint
+            }
+            selectRow(first);
+        }
+
+        solutionCount = 0;
+        solutionLimit = limit;
+        search(0);
+        return solutionCount;
+    }
+
+public:
+    BasicDLXSolver() : SudokuSolver(), L(NODES), R(NODES), U(NODES), D(NODES), C(NODES), rowOf(NODES), S(COLS + 1),
+                  covered(COLS + 1, false), selected(), depth(0), found(false),
+                  solutionCount(0), solutionLimit(1) {
+        // column headers, linked horizontally to the root
+        for (int c = 0; c <= COLS; c++) {
+            L[c] = c - 1;
+            R[c] = c + 1;
+            U[c] = D[c] = C[c] = c;
+            rowOf[c] = -1;
+            S[c] = 0;
+        }
+        L[ROOT] = COLS;
+        R[COLS] = ROOT;
+
+        // matrix rows
+        for (int cell = 0; cell < 81; cell++) {
+            int row = Board9::rowOf(cell), col = Board9::colOf(cell), grid = Board9::boxOf(cell);
+            for (int n = 0; n < 9; n++) {
+                int matrixRow = rowIndex(cell, n);
+                int columns[4] = {cell, 81 + row*9 + n, 162 + col*9 + n, 243 + grid*9 + n};
+                int first = rowStart(matrixRow);
+                for (int k = 0; k < 4; k++) {
+                    int node = first + k;
+                    int header = 1 + columns[k];
+                    // append to the bottom of the column
+                    C[node] = header;
+                    rowOf[node] = matrixRow;
+                    U[node] = U[header];
+                    D[node] = header;
+                    D[U[header]] = node;
+                    U[header] = node;
+                    S[header]++;
+                    // link inside the row
+                    L[node] = first + (k + 3) % 4;
+                    R[node] = first + (k + 1) % 4;
+                }
+            }
+        }
+    }
+
+    virtual void solve(SudokuBoard &sb) override {
+        Timer t;
+        Grid board = sb.getOriginalGrid();
+
+        if (solveMatrix(board, 1) == 1) { // if there was solution,
+            for (int i = 0; i < 81; i++) {
+                int row = rowOf[selected[i]];
+                board[row / 9] = 1 + row % 9;
+            }
+            // record time
+            sb.setElapsedTime(t.end());
+            // save answer
+            sb.setSolvedGrid(board);
+            sb.setAlgorithmUsed("dancing links");
+            if constexpr (Stats::enabled) sb.setStats(stats.get());
+        }
+        else {
+            // if couldn't solve the board, the board configuration was wrong, so we need to get another board.
+            // set `hasBoard` as false for signal.
+            sb.setHasBoard(false);
+        }
+        resourceClear();
+    }
+
+    virtual long long countSolutions(const SudokuBoard &sb, long long limit = 2) override {
+        long long count = solveMatrix(sb.getOriginalGrid(), limit);
+        resourceClear();
+        return count;
+    }
+
+    virtual std::unique_ptr<SudokuSolver> clone() const override {
+        return std::make_unique<BasicDLXSolver>();
+    }
+
+    /**
+     * restores the full matrix by unselecting every picked row, in reverse order. No memory is released or allocated.
+     */
+    virtual void resourceClear() override {
+        while (depth > 0) {
+            unselectRow(selected[depth - 1]);
+        }
+        found = false;
+        stats.clear();
+    }
+
+};
+
+using DLXSolver = BasicDLXSolver<>;
+using DLXSolverWithStats = BasicDLXSolver<CollectStats>;
+
+#endif //DLXSOLVER_H
@@ -0,0 +1,266 @@
+//
+// Built-in printed digit recognizer for sudoku cells: a linear model on 16x16 int8 features, with SIMD dispatch.
+//
+
+#ifndef DIGITCLASSIFIER_H
+#define DIGITCLASSIFIER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define DIGIT_CLASSIFIER_X86 1
+#include <immintrin.h>
+#endif
+
+#include "DigitWeights.h"
+
+/**
+ * Tesseract runs a whole LSTM line recognizer to read one printed digit. This reads it with one dot product per class:
+ *   - extract():  the ink of the cell (pixels >= 128, i.e. the white-on-black cells img_preprocess makes) is cropped to
+ *                 its bounding box, centered in a square and averaged down to 16x16 values 0..127. so position, size
+ *                 and stroke thickness mostly don't matter.
+ *   - classify(): score[d] = sum(features * weights[d]) + bias[d] in int8 x int8 -> int32, for a whole batch of cells.
+ *                 the AVX2 kernel does 32 multiplies per instruction (maddubs), so 81 cells are a few microseconds.
+ *                 confidence is the softmax probability of the best digit, in percent like Tesseract's.
+ *
+ * the weights (DigitWeights.h) are trained by digit_train on synthetic renders of printed digits, so real boards with
+ * unusual fonts can get low confidence: callers should send those cells to Tesseract.
+ */
+class DigitClassifier {
+public:
+    static constexpr int SIDE = 16;               // features are SIDE x SIDE
+    static constexpr int FEATURES = SIDE * SIDE;
+    static constexpr int CLASSES = 9;             // digits 1..9
+    static constexpr int MARGIN = 1;              // empty border around the digit in the feature image
+
+    // int8 weights per class and feature, int32 bias. logit = scale * (dot(features, weights[d]) + bias[d])
+    struct Model {
+        const int8_t (*weights)[FEATURES];
+        const int32_t *bias;
+        float scale;
+    };
+
+    struct Result {
+        uint8_t digit;     // 1-9, 0 if the cell has no ink
+        float confidence;  // 0-100
+    };
+
+    using ScoreFn = void (*)(const Model &model, const uint8_t *features, int count, int32_t *scores);
+
+    // a scoring implementation. best() picks the widest one the CPU supports, once.
+    struct Kernel {
+        const char *name;
+        ScoreFn scores;  // writes count * CLASSES scores
+    };
+
+    static Model builtinModel() {
+        return {DIGIT_WEIGHTS, DIGIT_BIAS, DIGIT_SCALE};
+    }
+
+    explicit DigitClassifier(const Model &model = builtinModel(), const Kernel &kernel = best())
+        : model(model), kernel(&kernel) {}
+
+    const char* getKernelName() const {
+        return kernel->name;
+    }
+
+    /**
+     * normalizes one cell crop into FEATURES values 0..127.
+     * TC: O(cell area)
+     * @param pixels 8-bit single channel, ink bright
+     * @param step bytes between rows
+     * @param features out, FEATURES bytes
+     * @return false if the cell has (almost) no ink, features are then all 0
+     */
+    static bool extract(const uint8_t *pixels, int cols, int rows, size_t step, uint8_t *features) {
+        std::memset(features, 0, FEATURES);
+        constexpr int MAX_SIDE = 256;
+        if (cols <= 0 || rows <= 0 || cols > MAX_SIDE || rows > MAX_SIDE) return false;
+
+        // ink per row and col. the box only takes rows/cols with 2+ ink pixels (a speckle doesn't stretch it) and
+        // less than 3/4 of the crop (a bit of grid line left at the edge isn't part of the digit)
+        int rowInk[MAX_SIDE] = {}, colInk[MAX_SIDE] = {}, ink = 0;
+        for (int y = 0; y < rows; y++) {
+            const uint8_t *row = pixels + y * step;
+            for (int x = 0; x < cols; x++) {
+                const int on = row[x] >= 128;
+                rowInk[y] += on, colInk[x] += on;
+            }
+            ink += rowInk[y];
+        }
+        if (ink < std::max(4, cols * rows / 100)) return false;
+        auto counts = [](const int &n, const int &across) { return n >= 2 && n * 4 < across * 3; };
+        int top = 0, bottom = rows - 1, left = 0, right = cols - 1;
+        while (top < rows && !counts(rowInk[top], cols)) top++;
+        while (bottom > top && !counts(rowInk[bottom], cols)) bottom--;
+        while (left < cols && !counts(colInk[left], rows)) left++;
+        while (right > left && !counts(colInk[right], rows)) right--;
+        if (top == rows || left == cols) return false;
+
+        // a side x side square centered on the ink box is mapped onto the inner (SIDE - 2*MARGIN)^2 of the feature
+        // image. positions are taken from the center (in half pixels), and a pixel exactly on the line between two
+        // feature cells counts half for each, so a turned crop gives exactly the turned features (see rotate()).
+        const int side = std::max(bottom - top + 1, right - left + 1);
+        const int inner = SIDE - 2 * MARGIN;
+        struct Cover {
+            int8_t first, second;  // feature row/col, second is -1 unless the pixel is split
+        };
+        auto cover = [&](const int &doubledOffset) {
+            const int pos = (doubledOffset + side) * inner;
+            const int8_t f = (int8_t) (pos / (2 * side));
+            return pos % (2 * side) == 0 ? Cover{(int8_t) (f - 1), f} : Cover{f, -1};
+        };
+        Cover colCover[MAX_SIDE];
+        for (int x = left; x <= right; x++) colCover[x] = cover(2 * x - (left + right));
+
+        uint32_t sum[FEATURES] = {};  // quarter pixels of ink
+        for (int y = top; y <= bottom; y++) {
+            const uint8_t *row = pixels + y * step;
+            const Cover cy = cover(2 * y - (top + bottom));
+            const int wy = cy.second < 0 ? 2 : 1;
+            for (int x = left; x <= right; x++) {
+                if (row[x] < 128) continue;
+                const Cover cx = colCover[x];
+                const int wx = cx.second < 0 ? 2 : 1;
+                sum[(MARGIN + cy.first) * SIDE + MARGIN + cx.first] += wy * wx;
+                if (cx.second >= 0) sum[(MARGIN + cy.first) * SIDE + MARGIN + cx.second] += wy * wx;
+                if (cy.second >= 0) {
+                    sum[(MARGIN + cy.second) * SIDE + MARGIN + cx.first] += wy * wx;
+                    if (cx.second >= 0) sum[(MARGIN + cy.second) * SIDE + MARGIN + cx.second] += wy * wx;
+                }
+            }
+        }
+        // ink fraction of each feature cell, whose area is (side / inner)^2 pixels
+        const uint64_t area4 = 4ull * side * side;
+        for (int f = 0; f < FEATURES; f++) {
+            const uint64_t v = (sum[f] * 127ull * inner * inner + area4 / 2) / area4;
+            features[f] = (uint8_t) std::min<uint64_t>(127, v);
+        }
+        return true;
+    }
+
+    // index in a size x size grid of what lands on (y, x) when the grid is turned quarterTurns * 90 degrees clockwise
+    static int rotatedSource(const int &y, const int &x, const int &size, const int &quarterTurns) {
+        switch (quarterTurns & 3) {
+            case 1: return (size - 1 - x) * size + y;
+            case 2: return (size - 1 - y) * size + (size - 1 - x);
+            case 3: return x * size + (size - 1 - y);
+            default: return y * size + x;
+        }
+    }
+
+    /**
+     * the features of the same cell turned quarterTurns * 90 degrees clockwise, without extracting it again.
+     * (extract() centers the ink, so this matches extracting the rotated crop up to a pixel of rounding)
+     * @param out FEATURES bytes, not the same buffer as `features`
+     */
+    static void rotate(const uint8_t *features, const int &quarterTurns, uint8_t *out) {
+        for (int y = 0; y < SIDE; y++) {
+            for (int x = 0; x < SIDE; x++) out[y * SIDE + x] = features[rotatedSource(y, x, SIDE, quarterTurns)];
+        }
+    }
+
+    /**
+     * classifies `count` cells in one pass.
+     * @param features count * FEATURES bytes, from extract()
+     * @param hasInk per cell, what extract() returned. cells without ink get digit 0, confidence 100.
+     * @param out count results
+     */
+    void classify(const uint8_t *features, const bool *hasInk, int count, Result *out) const {
+        int32_t scores[64 * CLASSES];
+        for (int start = 0; start < count; start += 64) {
+            const int n = std::min(64, count - start);
+            kernel->scores(model, features + (size_t) start * FEATURES, n, scores);
+            for (int i = 0; i < n; i++) {
+                Result &r = out[start + i];
+                if (!hasInk[start + i]) {
+                    r = {0, 100.0f};
+                    continue;
+                }
+                const int32_t *s = scores + i * CLASSES;
+                const int best = (int) (std::max_element(s, s + CLASSES) - s);
+                // softmax probability of the best class
+                double total = 0;
+                for (int d = 0; d < CLASSES; d++) total += std::exp((double) model.scale * (s[d] - s[best]));
+                r = {(uint8_t) (best + 1), (float) (100.0 / total)};
+            }
+        }
+    }
+
+    static const Kernel& scalar() {
+        static const Kernel k{"scalar", scoresScalar};
+        return k;
+    }
+
+#ifdef DIGIT_CLASSIFIER_X86
+    static const Kernel& avx2() {
+        static const Kernel k{"avx2", scoresAVX2};
+        return k;
+    }
+#endif
+
+    static const Kernel& best() {
+        static const Kernel &k = detect();
+        return k;
+    }
+
+private:
+    Model model;
+    const Kernel *kernel;
+
+    static const Kernel& detect() {
+#ifdef DIGIT_CLASSIFIER_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return avx2();
+#endif
+        return scalar();
+    }
+
+    static void scoresScalar(const Model &model, const uint8_t *features, int count, int32_t *scores) {
+        for (int i = 0; i < count; i++) {
+            const uint8_t *f = features + (size_t) i * FEATURES;
+            for (int d = 0; d < CLASSES; d++) {
+                int32_t s = model.bias[d];
+                for (int k = 0; k < FEATURES; k++) s += f[k] * model.weights[d][k];
+                scores[i * CLASSES + d] = s;
+            }
+        }
+    }
+
+#ifdef DIGIT_CLASSIFIER_X86
+    __attribute__((target("avx2")))
+    static int32_t horizontalSum(__m256i v) {
+        __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtsi128_si32(s);
+    }
+
+    // features are 0..127 and weights -127..127, so the pairwise int16 sums of maddubs can't saturate.
+    __attribute__((target("avx2")))
+    static void scoresAVX2(const Model &model, const uint8_t *features, int count, int32_t *scores) {
+        constexpr int VECTORS = FEATURES / 32;
+        const __m256i ones = _mm256_set1_epi16(1);
+        for (int i = 0; i < count; i++) {
+            const uint8_t *f = features + (size_t) i * FEATURES;
+            __m256i fv[VECTORS];
+            for (int v = 0; v < VECTORS; v++) fv[v] = _mm256_loadu_si256((const __m256i *) (f + v * 32));
+            for (int d = 0; d < CLASSES; d++) {
+                const int8_t *w = model.weights[d];
+                __m256i acc = _mm256_setzero_si256();
+                for (int v = 0; v < VECTORS; v++) {
+                    __m256i pairs = _mm256_maddubs_epi16(fv[v], _mm256_loadu_si256((const __m256i *) (w + v * 32)));
+                    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(pairs, ones));
+                }
+                scores[i * CLASSES + d] = horizontalSum(acc) + model.bias[d];
+            }
+        }
+    }
+#endif
+};
+
+#endif //DIGITCLASSIFIER_H
@@ -0,0 +1,178 @@
+//
+// Weights of the built-in DigitClassifier. Generated by digit_train, do not edit.
+//
+
+#ifndef DIGITWEIGHTS_H
+#define DIGITWEIGHTS_H
+
+#include <cstdint>
+
+// [digit - 1][16x16 feature, row major]
+alignas(32) inline const int8_t DIGIT_WEIGHTS[9][256] = {
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, -14, -28, -15, -5, -2, -53, -36, -15, -5, -6, 20, 21, 38, 11, 0,
+        0, -31, -36, 17, 11, 24, 24, 26, 51, 38, 37, 19, 17, 31, -8, 0,
+        0, -32, 25, 62, 40, 29, 66, 33, 65, 43, 67, 42, 29, 16, -73, 0,
+        0, 24, 64, 56, 50, 11, 57, 23, 17, 41, 12, 52, 1, -35, -75, 0,
+        0, 17, 14, 13, 24, 17, -6, 49, 33, 12, 3, 4, -41, -12, -61, 0,
+        0, -16, -33, -21, 3, -9, -10, -13, -3, -59, -88, -62, -72, -18, -30, 0,
+        0, -11, -4, -23, 0, -11, -40, -75, -46, -70, -96, -67, -73, -20, 10, 0,
+        0, -13, -5, -30, -5, -55, -30, -62, -56, -69, -79, -60, -71, -4, 0, 0,
+        0, -32, 14, -1, -25, -50, -27, -27, -21, -47, -55, -57, -17, 6, -24, 0,
+        0, -21, -10, -39, -1, -20, -27, -10, 1, -11, -36, -4, 24, -15, -19, 0,
+        0, -35, -32, -25, -19, -10, -20, -25, 17, 9, -13, 31, 36, -24, -8, 0,
+        0, -62, -35, -81, -46, -39, -13, 12, 28, 25, 11, -14, -14, -2, -17, 0,
+        0, -20, -30, -37, -31, -18, 5, 17, 17, 6, 25, 1, -30, 34, 7, 0,
+        0, 0, 24, 12, 5, 21, 30, -5, 5, 52, 55, 19, 35, 10, -1, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    },
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, -5, -2, 17, -4, 13, 24, 17, 29, -25, -42, -46, -43, -37, -25, 0,
+        0, 3, 29, 2, 19, 25, -10, 21, 18, -2, -6, -12, -16, -40, -30, 0,
+        0, 33, 14, 15, 14, 17, -23, 1, -2, -4, 4, 16, 27, 16, -8, 0,
+        0, 1, 26, 22, -2, -27, 0, -11, -5, -12, 12, 21, 45, 56, 37, 0,
+        0, -15, 3, -26, -34, -51, -30, -45, -25, 8, 37, 36, 26, 43, 63, 0,
+        0, -12, -20, -57, -75, -73, -67, -86, -39, -22, 31, 26, 14, 35, 50, 0,
+        0, -23, -39, -73, -102, -85, -83, -61, -69, -52, -44, -1, 2, 35, 15, 0,
+        0, -29, -39, -57, -46, -47, -49, -27, -72, -17, -69, -10, -15, -40, -27, 0,
+        0, -11, -16, -9, -2, -2, 2, 2, 0, -28, -53, -22, -60, -71, -45, 0,
+        0, -16, 7, 47, 54, 39, 52, 63, 69, 16, 21, -54, -89, -70, -58, 0,
+        0, -26, 60, 67, 48, 61, 53, 39, 20, 20, -46, -66, -67, -71, -49, 0,
+        0, 51, 34, 64, 64, 37, 76, 39, 23, 17, -17, 14, 7, -6, 23, 0,
+        0, 51, 32, 40, 23, 28, 21, 21, 23, -4, 41, 34, -15, 14, 37, 0,
+        0, 12, 8, 15, 27, 36, 21, 50, 54, 55, 62, 46, 6, 26, 18, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    },
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 17, 31, 36, 40, 43, 43, 35, 28, -6, -23, -10, 14, 23, -4, 0,
+        0, 9, 9, 35, 28, 29, 27, -4, -32, -3, 12, -27, -3, -4, -24, 0,
+        0, 6, -14, -21, 10, 18, 10, 5, 9, -14, -4, 1, -10, 11, 9, 0,
+        0, 1, -56, -52, -27, -46, 3, 12, 10, 14, 19, -16, 10, -6, 9, 0,
+        0, -23, -49, -54, -67, -59, -8, -11, 47, -9, -42, -9, 19, -13, -22, 0,
+        0, -16, -46, -37, -41, -59, -44, 3, -14, 23, 5, -23, -24, -41, -21, 0,
+        0, -32, -43, 8, 1, -44, -26, 11, 5, 29, 37, 13, 2, -51, -49, 0,
+        0, -23, -45, -34, -55, -89, -63, -28, -44, -22, -1, -9, -12, 5, -4, 0,
+        0, -22, -18, -27, -24, 11, -34, -53, -17, 34, 36, 13, 18, 41, 19, 0,
+        0, -9, -9, -41, -83, -44, 12, -26, -10, 12, 15, 34, 30, 34, 59, 0,
+        0, 79, 36, 29, 3, -22, -6, 33, -4, -26, 18, 43, 34, 69, 63, 0,
+        0, 68, 86, 57, 78, 67, 43, 8, 24, 1, -8, 5, 16, 33, 42, 0,
+        0, -14, 48, 47, 51, 52, 36, 19, 9, 18, 15, -21, 7, 10, -10, 0,
+        0, -23, -16, -8, 2, 5, 47, 41, 28, -6, -43, -16, -9, -12, 10, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    },
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, -6, -21, -36, -60, -57, -31, -19, -40, -13, 0, 24, -10, -6, 15, 0,
+        0, -6, -40, -50, -63, -83, -60, -32, -16, 19, -30, -3, -20, -16, 5, 0,
+        0, -27, -48, -43, -52, -8, -33, -12, -8, -6, -15, -5, -5, -20, 4, 0,
+        0, -18, -40, -30, -49, -16, -48, -29, -46, -9, -58, -18, -50, -9, 4, 0,
+        0, -28, -29, -10, -34, -22, 3, -38, -23, -13, -26, -17, 7, -15, -13, 0,
+        0, -28, -6, 14, 25, 24, 42, 1, -8, -32, -4, -22, -20, -7, -15, 0,
+        0, -13, 17, 22, 68, 59, 56, 58, 11, 30, 38, -17, -20, -29, -16, 0,
+        0, 41, 51, 40, 63, 73, 83, 33, 61, 32, 14, -9, 34, -17, -34, 0,
+        0, 79, 74, 68, 103, 37, 38, 72, 66, 47, 61, 30, 52, 42, 31, 0,
+        0, 40, 83, 97, 119, 113, 15, 50, 42, 59, 35, 64, 28, 25, 10, 0,
+        0, -24, 12, -1, 42, 10, 9, -18, -5, 53, 43, 33, 12, -5, -38, 0,
+        0, -15, 0, -8, -47, -36, -42, -31, -35, -10, 35, 2, 6, -16, -23, 0,
+        0, 18, 0, -7, -10, -49, -72, -38, -57, -17, -14, 54, 73, 26, 27, 0,
+        0, 36, 37, 6, 9, -32, -87, -97, -84, -24, 65, 21, 69, 54, 10, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    },
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, -2, 11, -8, -21, -13, 18, 3, 5, 57, 66, 45, 41, 20, 14, 0,
+        0, 8, 9, -15, 0, -1, -9, -20, -14, -29, 2, 31, 34, 34, 73, 0,
+        0, 7, 11, 21, 13, 21, 31, -8, -15, -23, -43, -54, -55, -70, -6, 0,
+        0, -6, 17, 33, 18, 32, 21, 41, 32, -29, -13, -43, -70, -81, -42, 0,
+        0, 15, 37, 67, 55, 58, 56, 51, -7, -9, -50, -29, -45, -81, -38, 0,
+        0, 32, 72, 102, 97, 77, 63, 33, 9, 39, -21, 3, 27, -45, -40, 0,
+        0, 61, 58, 1, 12, 40, 10, -2, 13, 9, -36, -28, 0, 3, -1, 0,
+        0, -3, -21, -35, -3, 18, 1, 40, -16, -17, 20, 2, -4, 26, 22, 0,
+        0, -59, -79, -74, -118, -50, -36, -80, -69, 9, 11, 4, 1, 22, 30, 0,
+        0, -21, -64, -72, -127, -93, -44, -21, -8, -21, 23, 33, 38, 41, 13, 0,
+        0, -16, -39, -30, -48, -23, -42, -6, 2, 3, 25, 40, 49, 22, 15, 0,
+        0, 3, -13, -4, 37, 17, -12, 2, 9, 27, 12, 43, 36, 12, 21, 0,
+        0, 2, -9, -4, -9, 12, -2, -8, 22, 7, -32, 23, 12, 10, -5, 0,
+        0, -5, -8, 3, -24, -17, 3, 21, 10, -30, -19, 3, 2, -18, -10, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    },
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, -7, -41, -66, -59, -32, -38, 7, -1, -11, -26, -9, -8, 1, 0,
+        0, -22, -66, -68, -107, -69, -23, -36, -18, -30, -43, -47, -62, -29, -23, 0,
+        0, -40, -39, -58, -72, -81, -18, -35, -49, -41, -56, -36, -32, -24, -38, 0,
+        0, -44, -24, -19, -37, -27, -58, -40, -7, -37, -36, -48, -23, -68, -62, 0,
+        0, -16, -2, -18, -7, -37, -33, -28, 7, -4, -68, -79, -90, -88, -60, 0,
+        0, 13, -5, 30, 78, 39, 81, 52, 29, 28, -26, 19, 6, -44, -39, 0,
+        0, 55, 48, 99, 87, 94, 49, 78, 49, 44, 74, 69, 55, 50, 12, 0,
+        0, 51, 72, 55, 68, 27, 18, -2, -1, -4, 13, 49, 15, 58, 62, 0,
+        0, 12, 26, 14, 41, 92, 9, 14, 8, -25, 37, 38, 43, 44, 54, 0,
+        0, 13, 18, 52, 36, 76, -5, -22, -48, -10, 10, 39, 66, 51, 62, 0,
+        0, 35, 36, 14, 1, 15, 15, 27, 10, 16, -6, 12, 9, 54, 66, 0,
+        0, -2, 13, -5, -21, 16, 11, -7, -3, 6, 39, -5, 35, 43, 6, 0,
+        0, -23, 10, -11, -12, 18, 22, -5, 21, 5, 10, 19, 38, -4, -6, 0,
+        0, -15, -37, -13, -3, 14, 24, -8, -6, -11, -22, 13, -4, -16, -10, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    },
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 29, 55, 57, 98, 114, 51, 12, -14, 17, 46, 37, 21, 41, 27, 0,
+        0, 53, 59, 59, 91, 60, 48, 56, 19, 3, 19, 47, 33, 49, 59, 0,
+        0, 44, 18, 10, 43, 28, -9, 47, 8, 34, 36, 43, 41, 59, 88, 0,
+        0, 11, -24, -28, 16, 32, -12, 27, 24, 49, 61, 29, 41, 51, 44, 0,
+        0, -8, -26, -33, -11, 24, -6, 40, 21, 5, 84, 30, 33, 59, 11, 0,
+        0, -21, -25, -41, -97, -43, -63, -42, -22, -43, 21, -12, 9, 7, -6, 0,
+        0, -18, -29, -52, -97, -75, -69, -56, -46, -38, -54, -26, -31, -41, -16, 0,
+        0, -6, -32, -38, -66, -67, -49, -31, -21, -2, -46, -32, -21, -57, -25, 0,
+        0, 6, -29, -39, -46, -81, -39, -16, -26, -8, -51, -29, -33, -51, -36, 0,
+        0, -6, -21, -19, -27, -47, -34, -32, -33, -45, -29, -14, -47, -45, -35, 0,
+        0, -20, -44, -27, -28, -36, -3, -30, -13, -18, -29, -46, -49, -52, -36, 0,
+        0, -20, -40, -14, -8, -2, 17, 30, -6, -16, -39, -34, -53, -59, -31, 0,
+        0, -11, -10, -15, 7, 3, -2, 7, -5, -27, -26, -61, -56, -47, -24, 0,
+        0, -10, -3, -2, 1, 9, -13, -13, -18, -9, -48, -65, -71, -30, -18, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    },
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, -8, -13, 10, 13, -19, -12, 3, 3, -8, -36, -35, -27, -46, -22, 0,
+        0, 6, 24, -13, -4, 9, -12, -17, -16, -23, -8, -4, -12, -24, -23, 0,
+        0, 5, 2, -6, 1, -40, -20, -43, -25, 2, -23, -1, 0, -8, 38, 0,
+        0, 1, -9, -6, 0, 27, 18, -11, -32, -18, -2, 6, 28, 49, 64, 0,
+        0, 7, 3, 1, -5, 9, 8, 20, 17, 43, 31, 33, 59, 54, 62, 0,
+        0, -23, 1, -9, -4, 31, 11, 31, 35, 50, 49, 42, 24, 71, 31, 0,
+        0, -56, -50, 20, 8, 7, 75, 44, 64, 44, 64, 31, 34, -14, -38, 0,
+        0, -5, -3, 32, 31, 84, 52, 55, 86, 59, 86, 10, 36, -14, -44, 0,
+        0, 71, 77, 47, 39, 54, 29, 25, 26, -20, -5, -7, -13, -11, -16, 0,
+        0, 68, 62, 48, 70, 17, 10, -4, 0, 4, -14, -44, -17, -14, 20, 0,
+        0, 67, 54, 21, 40, 38, 5, -7, -8, -20, 19, -6, 11, 37, 27, 0,
+        0, 26, 39, 29, -14, -9, -35, -24, -18, -31, -2, 34, 6, 40, 15, 0,
+        0, -6, -33, 5, 13, -4, 6, -21, -18, 5, 9, -4, 5, -8, -8, 0,
+        0, -12, -44, -23, -12, -29, -5, -1, 5, 0, -11, 2, -4, 5, 4, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    },
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, -11, -25, -22, 5, -18, -8, 22, -2, -16, 6, -9, -9, -25, -17, 0,
+        0, -20, 11, 33, 24, 6, 15, 7, 7, 28, 18, -2, 29, -2, -28, 0,
+        0, 4, 29, 20, 2, 16, -4, 13, 16, 8, 34, -7, 5, 20, -15, 0,
+        0, 30, 47, 25, 30, 14, 18, -11, 7, 0, 4, 17, 19, 43, 21, 0,
+        0, 51, 50, 58, 79, 61, 15, -37, -69, -33, 31, 31, 31, 53, 57, 0,
+        0, 71, 62, 19, 15, 13, -13, 21, 13, 16, 33, 29, 35, 43, 71, 0,
+        0, 37, 43, -3, 24, 16, 27, 2, 20, 3, 19, 25, 30, 67, 83, 0,
+        0, -13, 23, 67, 12, 56, 37, 23, 63, 40, 62, 59, 38, 42, 52, 0,
+        0, -44, -50, 23, 32, -12, 58, 63, 33, 39, 19, 31, 8, -22, -13, 0,
+        0, -48, -67, -74, -41, -42, 22, 3, -13, -5, -25, -52, -32, -8, -50, 0,
+        0, -60, -84, -49, -40, -33, -11, -13, -19, -36, -11, -40, -35, -30, -40, 0,
+        0, -48, -85, -38, -41, -52, -44, -30, -20, -18, -31, -45, -39, -45, -36, 0,
+        0, 2, -8, -19, -31, -42, -13, 8, -12, 7, -27, -44, -33, -35, -18, 0,
+        0, 17, 39, 10, -4, -7, -20, 10, 7, -26, -38, -23, -24, -19, -4, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    },
+};
+inline const int32_t DIGIT_BIAS[9] = {31787, 8565, 2253, -10295, -3009, -8401, 19599, -30176, -10246};
+inline const float DIGIT_SCALE = 0.000148142164f;
+
+#endif //DIGITWEIGHTS_H
@@ -5,21 +5,23 @@
 #ifndef HEURISTICSBACKTRACKINGSOLVER_H
 #define HEURISTICSBACKTRACKINGSOLVER_H
 
-#include <queue>
-#include <utility>
-
-#include "BacktrackingSolver.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "BoardShape.h"
+#include "CandidateKernel.h"
+#include "SolveStats.h"
+#include "SudokuBoard.h"
 #include "SudokuSolver.h"
+#include "Timer.h"
 
 /* CONSIDERATIONS FOR EFFICIENCY IMPROVEMENT
- * NOTE: overall, I'm very unsatisfied with this code I have written. There are lots of places where I'm copying entire 2d vector or some map of set, in each recursion.
- * Also, there are O(1) TC functions with lots of lots of operations lol.. while coding, I took note of some things to fix:
- *
- * TODO: lookup for the cell with least candidates is unefficient as it iterates 81 times every time to find the min cell. find lazy way to do this?
- *  - I was thinking of using minheap but it's not good. As we need to construct minheap every time and that's O(N)
- * TODO: ruleBased returns an r-value. Instead of this, let's make it void fxn and change things directly with the passed parameter.
- *
- * TODO: don't erase or insert to every cell in row/col/grid. just insert to those that are empty. also, try not to repeat.
+ * NOTE: overall, I'm very unsatisfied with this code I have written. There are O(1) TC functions with lots of lots of operations lol..
  */
 
 /**
@@ -38,7 +40,13 @@
  *   while (true) { // while we can figure things out with heuristics
  *     if (applyNakedSingle(board))
  *       continue
- *     if (applyNakedTuple(board))
+ *     if (applyHiddenSingle(board))
+ *       continue
+ *     if (applyLockedCandidates())
+ *       continue
+ *     if (applyNakedTuple())
+ *       continue
+ *     if (applyHiddenTuple())
  *       continue
  *      break;
  *   }
@@ -56,32 +64,128 @@
  *
  *   return null; // if none of guesses lead to some valid board solution, this configuration doesn't have answer.
  */
-class HeuristicsBacktrackingSolver : public SudokuSolver {
-    // mapping of cell 1-81 to available numbers to put in that cell
-    // this should be updated everytime a number is put or erased.
-    std::unordered_map<int, std::unordered_set<char>> cellCandidates;
-
-    // these are ONLY used in isSolved function for checking if the board is solved.
-    // rowset/colset maps row/col index to corresponding set
-    // gridset maps the index of left top corner of each grid to the set of that grid.
-    // Ex: gridset[0] is valid(1st grid), gridset[30] is valid (this is the 5th grid).
-    std::unordered_map<int, std::unordered_set<char>> rowset, colset, gridset;
+template <typename Stats = NoStats>
+class BasicHeuristicsBacktrackingSolver : public SudokuSolver {
+public:
+    // the propagation rules of ruleBased, tried in the order of the enum.
+    using Rule = SolveRule;
+
+private:
+    // candidate mask of cell 0-80. bit (n-1) is set if number n can still be put in that cell.
+    // filled cells have mask 0. this should be updated everytime a number is put or erased.
+    // padded to CandidateKernel::LANES with zeros so the SIMD kernel can load it in whole registers.
+    alignas(32) std::array<uint16_t, CandidateKernel::LANES> cellCandidates;
+
+    // the same candidates transposed: digitCells[n-1] is the set of cells where number n is still a candidate.
+    // hidden rules ask "where can n go in this unit", which is digitCells[n-1] & unit instead of a loop over 9 cells.
+    std::array<CellSet, 9> digitCells;
+
+    // SIMD (or scalar fallback) implementation used for scanning and peer elimination.
+    const CandidateKernel* kernel;
+
+    // occupancy masks. bit (n-1) is set if number n is already placed in that row/col/grid.
+    // gridMask is indexed by grid number 0-8 (left to right, top to bottom).
+    std::array<uint16_t, 9> rowMask, colMask, gridMask;
+
+    // empty cells, bucketed by how many candidates they have: cellsByCount[k] holds the empty cells with k candidates.
+    // kept up to date on every mask change, so the best cell to guess is found without scanning the board.
+    std::array<CellSet, 10> cellsByCount;
+    CellSet emptyCells;
+    // solutions found so far, and how many to find before the search stops (1 when solving).
+    long long solutionCount, solutionLimit;
+
+    // which rules ruleBased may use.
+    std::array<bool, RULE_COUNT> ruleEnabled;
+    Stats stats;
+
+    // parallel mode (see setParallel). 1 thread = plain sequential search.
+    unsigned parallelThreads;
+    int splitDepth;
+    // true while solve() runs its search: the only search allowed to go parallel (countSolutions never does).
+    bool parallelSearch;
+    // set in branch copies while a parallel solve runs: raised once some branch found the solution.
+    std::atomic<bool>* cancel;
+
+    static constexpr uint16_t ALL_CANDIDATES = 0x1FF;
+
+    // one undoable change. CANDIDATES: cell had candidate mask `value` before. ASSIGNMENT: number `value` was put in cell.
+    struct TrailEntry {
+        enum Kind : uint8_t { CANDIDATES, ASSIGNMENT } kind;
+        uint8_t cell;
+        uint16_t value;
+    };
+    // every change made since the solve started, oldest first. masks only lose bits while searching, so there can be
+    // at most 81*9 candidate changes plus 81 assignments. the buffer lives with the solver and is reused across solves.
+    static constexpr int TRAIL_CAPACITY = 81 * 9 + 81 + 1; // +1: removeCandidates writes one entry past the end
+    std::array<TrailEntry, TRAIL_CAPACITY> trail;
+    int trailSize;
+
+    static int popcount(uint16_t mask) { return __builtin_popcount(mask); }
+    // number (1-9) of the lowest candidate in the mask. mask must not be 0.
+    static uint8_t lowestCandidate(uint16_t mask) { return 1 + __builtin_ctz(mask); }
+    static uint16_t bitOf(const uint8_t &n) { return 1 << (n - 1); }
+
+    // Board9's units as CellSets: 0-8 rows, 9-17 cols, 18-26 grids (same order as CandidateKernel::unitUnions).
+    static constexpr std::array<CellSet, 27> makeUnitCells() {
+        std::array<CellSet, 27> u{};
+        for (int unit = 0; unit < 27; unit++) {
+            for (int cell : Board9::unitCells(unit)) u[unit].set(cell);
+        }
+        return u;
+    }
+    static const std::array<CellSet, 27>& unitCells() {
+        static constexpr std::array<CellSet, 27> units = makeUnitCells(); // built by the compiler, no init guard
+        return units;
+    }
+    // numbers already placed in unit u (numbered as in unitCells)
+    uint16_t placedIn(const int &u) const {
+        return u < 9 ? rowMask[u] : u < 18 ? colMask[u - 9] : gridMask[u - 18];
+    }
 
 public:
-    HeuristicsBacktrackingSolver() : SudokuSolver() {
+    BasicHeuristicsBacktrackingSolver() : SudokuSolver(), kernel(&CandidateKernel::best()) {
+        ruleEnabled.fill(true);
+        parallelThreads = 1;
+        splitDepth = 1;
+        cancel = nullptr;
+        resourceClear();
+    }
+
+    /**
+     * parallel speculative search, for the latency of one hard puzzle: at the first guess point, every configuration
+     * `depth` guesses below it gets its own copy of the solver and the copies race on `threads` threads (0 = one
+     * per core). the first to find the solution cancels the rest. only solve() uses it, countSolutions stays sequential.
+     * with threads = 1 (the default) the solver is sequential. solveBatch workers get at most their share of the
+     * cores each (see cloneForBatch), so a batch doesn't run threads * cores threads.
+     */
+    void setParallel(unsigned threads, int depth = 1) {
+        parallelThreads = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+        splitDepth = std::max(1, depth);
+    }
+
+    // turn a propagation rule off (or back on), e.g. to see how many guesses it saves against the time it costs.
+    void setRuleEnabled(const Rule &rule, bool enabled) {
+        ruleEnabled[rule] = enabled;
+    }
 
+    // choose the candidate kernel explicitly, e.g. CandidateKernel::scalar() to compare against the SIMD path.
+    void setKernel(const CandidateKernel& k) {
+        kernel = &k;
+    }
+    const char* getKernelName() const {
+        return kernel->name;
     }
     // Function to print candidates for each cell in a formatted Sudoku board way
     void printCandidates() {
         for (int row = 0; row < 9; row++) {
             for (int col = 0; col < 9; col++) {
                 int cellIndex = row * 9 + col;
-                if (cellCandidates.at(cellIndex).empty()) {
+                if (cellCandidates[cellIndex] == 0) {
                     std::cout << " . ";  // Empty cell (no candidates)
                 } else {
                     std::cout << "{";
-                    for (const auto& candidate : cellCandidates.at(cellIndex)) {
-                        std::cout << candidate;
+                    for (uint16_t m = cellCandidates[cellIndex]; m; m &= m - 1) {
+                        std::cout << (char) ('0' + lowestCandidate(m));
                     }
                     std::cout << "} ";
                 }
@@ -101,299 +205,585 @@ public:
     }
 
     /**
-     * erases `n` from available number set of other cells in the same row, col, and grid.
-     * TC: O(1), Θ(27)
-     * @param row
-     * @param col
-     * @param n
+     * moves an empty cell to the bucket of its new candidate count. filled cells are in no bucket.
+     * TC: O(1)
+     * @param cell
+     * @param oldMask
+     * @param newMask
      */
-    void putNumber(const int &row, const int &col, const char &n) {
-        // erase n from itself
-        // cellCandidates[row*9+col].erase(n);
-        cellCandidates[row*9+col].clear();
-        // erase n from all cells in the same row
-        for (int i = 0; i < 9; i++)
-            cellCandidates[row*9+i].erase(n);
-        // erase n from all cells in the same col
-        for (int i = 0; i < 9; i++)
-            cellCandidates[9*i+col].erase(n);
-        // erase n from all cells in the same grid
-        int grid_start_pos = (row/3)*3*9 + (col/3)*3; // this will find the "left upper cell" in the grid it's in.
-        for (int i = 0; i < 3; i++) {
-            for (int j = 0; j < 3; j++)
-                cellCandidates[grid_start_pos+i*9+j].erase(n);
-        }
+    void moveBucket(const int &cell, const uint16_t &oldMask, const uint16_t &newMask) {
+        if (oldMask == newMask || !emptyCells.test(cell)) return;
+        cellsByCount[popcount(oldMask)].reset(cell);
+        cellsByCount[popcount(newMask)].set(cell);
     }
 
     /**
-     * adds `n` to available number set of other cells in the same row, col, and grid.
-     * TC: O(1), Θ(27)
-     * @param row
-     * @param col
+     * removes `mask` from the candidates of `cell`, recording the old mask in the trail if something changed.
+     * @param cell
+     * @param mask
+     * @return true if some candidate was removed
+     */
+    bool removeCandidates(const int &cell, const uint16_t &mask) {
+        uint16_t old = cellCandidates[cell];
+        bool changed = (old & mask) != 0;
+        // written unconditionally and kept only if something changed, so the peer loops don't branch on it.
+        trail[trailSize] = {TrailEntry::CANDIDATES, (uint8_t) cell, old};
+        trailSize += changed;
+        cellCandidates[cell] = old & ~mask;
+        moveBucket(cell, old, cellCandidates[cell]);
+        for (uint16_t removed = old & mask; removed; removed &= removed - 1)
+            digitCells[__builtin_ctz(removed)].reset(cell);
+        return changed;
+    }
+
+    /**
+     * puts `n` in the cell, and erases `n` from candidate mask of other cells in the same row, col, and grid.
+     * every change is recorded in the trail so that undoTo() can revert it.
+     * TC: O(1), a few vector ops + Θ(number of peers that had `n`)
+     * @param board
+     * @param cell
      * @param n
-     * @param candidateset
      */
-    void eraseNumber(const int &row, const int &col, const char &n, std::unordered_set<char> candidateset) {
-        // erase n from itself
-        cellCandidates[row*9+col] = std::move(candidateset);
-        // erase n from all cells in the same row
-        for (int i = 0; i < 9; i++)
-            cellCandidates[row*9+i].insert(n);
-        // erase n from all cells in the same col
-        for (int i = 0; i < 9; i++)
-            cellCandidates[9*i+col].insert(n);
-        // erase n from all cells in the same grid
-        int grid_start_pos = (row/3)*3*9 + (col/3)*3; // this will find the "left upper cell" in the grid it's in.
-        for (int i = 0; i < 3; i++) {
-            for (int j = 0; j < 3; j++)
-                cellCandidates[grid_start_pos+i*9+j].insert(n);
-        }
+    void putNumber(Grid& board, const int &cell, const uint8_t &n) {
+        const uint16_t bit = bitOf(n);
+        board[cell] = n;
+        trail[trailSize++] = {TrailEntry::ASSIGNMENT, (uint8_t) cell, n};
+        emptyCells.reset(cell);
+        cellsByCount[popcount(cellCandidates[cell])].reset(cell);
+        rowMask[Board9::rowOf(cell)] |= bit;
+        colMask[Board9::colOf(cell)] |= bit;
+        gridMask[Board9::boxOf(cell)] |= bit;
+        // the cell itself has no candidates anymore
+        removeCandidates(cell, ALL_CANDIDATES);
+        // erase n from all cells in the same row, col and grid in one pass, then record the peers that lost it.
+        CellSet changed = kernel->eliminate(cellCandidates.data(), cell, bit);
+        digitCells[n - 1].remove(changed);
+        changed.forEach([&](int peer) {
+            uint16_t old = cellCandidates[peer] | bit;
+            trail[trailSize++] = {TrailEntry::CANDIDATES, (uint8_t) peer, old};
+            moveBucket(peer, old, cellCandidates[peer]);
+        });
     }
 
     /**
-     * returns true if board is full and correct
-     * TC: O(1), Θ(81)
+     * reverts every change recorded after the trail had `mark` entries, newest first.
+     * this is how backtracking restores the state, instead of copying the board and the masks at every guess.
      * @param board
-     * @return bool
+     * @param mark trail size to go back to
      */
-    bool isSolved(std::vector<std::vector<char>>& board) {
-        rowset.clear(), colset.clear(), gridset.clear(); // clear the set before using.
-        int row, col, grid;
-        char num;
-        for (int i=0; i<81; i++) {
-            num = board[i/9][i%9];
-            row = i/9;
-            col = i%9;
-            grid = (row/3)*3*9 + (col/3)*3;
-            if (num == '.') return false; // board incomplete
-            if (rowset[row].find(num) == rowset[row].end() && colset[col].find(num) == colset[col].end() && gridset[grid].find(num) == gridset[grid].end()) {
-                rowset[row].insert(num);
-                colset[col].insert(num);
-                gridset[grid].insert(num);
+    void undoTo(Grid& board, const int &mark) {
+        while (trailSize > mark) {
+            const TrailEntry &e = trail[--trailSize];
+            if (e.kind == TrailEntry::CANDIDATES) {
+                for (uint16_t restored = e.value & ~cellCandidates[e.cell]; restored; restored &= restored - 1)
+                    digitCells[__builtin_ctz(restored)].set(e.cell);
+                moveBucket(e.cell, cellCandidates[e.cell], e.value);
+                cellCandidates[e.cell] = e.value;
             }
             else {
-                return false;
+                const uint16_t clear = ~bitOf(e.value);
+                board[e.cell] = 0;
+                emptyCells.set(e.cell);
+                cellsByCount[popcount(cellCandidates[e.cell])].set(e.cell);
+                rowMask[Board9::rowOf(e.cell)] &= clear;
+                colMask[Board9::colOf(e.cell)] &= clear;
+                gridMask[Board9::boxOf(e.cell)] &= clear;
             }
         }
-        return true;
     }
 
     /**
-     * finds the empty cell with least number of candidates
+     * returns true if board is full and correct
      * TC: O(1), Θ(81)
      * @param board
-     * @return index of cell with min candidate. 0 if there's not.
+     * @return bool
      */
-    int findCellWithLeastCandidates(std::vector<std::vector<char>>& board) {
-        int minCell = 0, minCandidates = INT_MAX;
-        int sz;
-        for (int i = 0; i < 81; i++) {
-            sz = cellCandidates[i].size();
-            if (board[i/9][i%9] == '.' && sz < minCandidates && sz != 0) {
-                minCandidates = sz;
-                minCell = i;
+    bool isSolved(const Grid& board) {
+        if (!emptyCells.empty()) return false; // board incomplete
+        uint16_t units[27] = {};
+        for (int cell = 0; cell < 81; cell++) {
+            uint8_t num = board[cell];
+            if (num == 0) return false; // board incomplete
+            uint16_t bit = bitOf(num);
+            for (int u : Board9::unitsOf(cell)) {
+                if (units[u] & bit) return false; // duplicate
+                units[u] |= bit;
             }
         }
-        return minCell;
+        return true;
+    }
+
+    /**
+     * finds the empty cell with least number of candidates, from the candidate count buckets.
+     * TC: O(1), at most 10 bucket checks
+     * @return index of cell with min candidate. -1 if some empty cell has no candidate left (dead end).
+     */
+    int findCellWithLeastCandidates() {
+        if (!cellsByCount[0].empty()) return -1;
+        for (int k = 1; k <= 9; k++) {
+            if (!cellsByCount[k].empty()) return cellsByCount[k].lowest();
+        }
+        return -1;
     }
 
     /**
      * Apply the Naked Single Rule: if there is a cell with only 1 possible candidate, place it,
      * and erase it from candidate list of other cells in the same row/col/grid
-     * TC: O(1), Θ(81 + 27 * number of naked single)
+     * TC: O(1), one kernel scan + one putNumber per naked single
+     * @param board
+     * @return true if something was modified
+     */
+    bool applyNakedSingle(Grid& board) {
+        bool flag = false;
+        CellSet singles = kernel->scan(cellCandidates.data()).singles;
+        singles.forEach([&](int i) {
+            uint16_t m = cellCandidates[i];
+            if (m == 0) return; // lost its only candidate to a single placed earlier in this pass
+            flag = true;
+            putNumber(board, i, lowestCandidate(m));
+        });
+        return flag;
+    }
+
+    /**
+     * Apply the Hidden Single Rule: if a number is missing from a unit (row/col/grid) and only one cell of the unit
+     * can still take it, place it there, even if that cell has other candidates.
+     * with the digit planes this is one CellSet AND + popcount per (unit, missing number).
+     * TC: O(1), 27 * 9 checks + one putNumber per hidden single
      * @param board
      * @return true if something was modified
      */
-    bool applyNakedSingle(std::vector<std::vector<char>>& board) {
+    bool applyHiddenSingle(Grid& board) {
         bool flag = false;
-        for (int i = 0; i < 81; i++) {
-            if (board[i/9][i%9] == '.' && cellCandidates[i].size() == 1) {
+        const std::array<CellSet, 27>& units = unitCells();
+        for (int u = 0; u < 27; u++) {
+            for (uint16_t missing = ALL_CANDIDATES & ~placedIn(u); missing; missing &= missing - 1) {
+                int d = __builtin_ctz(missing);
+                CellSet places = digitCells[d] & units[u];
+                if (places.count() != 1) continue; // no place at all is a dead end, hasDeadUnit catches it
+                int cell = places.lowest();
+                putNumber(board, cell, d + 1);
                 flag = true;
-                auto num = *cellCandidates[i].begin();
-                board[i/9][i%9] = num;
-                putNumber(i/9, i%9, num);
             }
         }
         return flag;
     }
 
-    // Custom hash function for unordered_set<char>
-    struct UnorderedSetHash {
-        std::size_t operator()(const std::unordered_set<char>& s) const {
-            std::size_t hash = 0;
-            for (const char& elem : s) {
-                hash ^= std::hash<char>()(elem);
+    /**
+     * Apply the Locked Candidates Rule, where a grid meets a row or col:
+     *   - pointing: if number n can only go in one row (col) inside a grid, n must be in that grid's part of the row,
+     *     so erase it from the rest of the row.
+     *   - claiming: if n can only go in one grid inside a row (col), erase it from the rest of the grid.
+     * Example, if 5 only fits in the top row of the first grid, no other cell of the top row can take 5.
+     * TC: O(1), 9 grids * 6 crossing lines * missing numbers, a few CellSet ops each
+     * @return true if something was modified
+     */
+    bool applyLockedCandidates() {
+        bool flag = false;
+        const std::array<CellSet, 27>& units = unitCells();
+        for (int grid = 0; grid < 9; grid++) {
+            const CellSet &box = units[18 + grid];
+            // the 3 rows and 3 cols crossing this grid, from its top left cell
+            const int corner = Board9::unitCells(18 + grid)[0];
+            const int row = Board9::rowOf(corner), col = Board9::colOf(corner);
+            const int lines[6] = {row, row + 1, row + 2, 9 + col, 9 + col + 1, 9 + col + 2};
+            for (uint16_t missing = ALL_CANDIDATES & ~gridMask[grid]; missing; missing &= missing - 1) {
+                int d = __builtin_ctz(missing);
+                for (const int &l : lines) {
+                    const CellSet &line = units[l];
+                    CellSet inBox = digitCells[d] & box;
+                    CellSet inLine = digitCells[d] & line;
+                    CellSet inter = inBox & line;
+                    if (inter.empty()) continue;
+
+                    CellSet rest;
+                    if (inter == inBox) { // pointing
+                        rest = inLine;
+                        rest.remove(box);
+                    }
+                    else if (inter == inLine) { // claiming
+                        rest = inBox;
+                        rest.remove(line);
+                    }
+                    // every cell in `rest` has d as candidate, so anything in it is a change
+                    rest.forEach([&](int cell) { removeCandidates(cell, 1 << d); });
+                    if (!rest.empty()) flag = true;
+                }
             }
-            return hash;
         }
-    };
+        return flag;
+    }
 
-    // Custom equality function for unordered_set<char>
-    struct UnorderedSetEqual {
-        bool operator()(const std::unordered_set<char>& s1, const std::unordered_set<char>& s2) const {
-            return s1 == s2;
-        }
-    };
+    /**
+     * removes every candidate except `numbers` from the given cells.
+     * @return true if some candidate was removed
+     */
+    bool keepOnly(const CellSet &cells, const uint16_t &numbers) {
+        bool flag = false;
+        cells.forEach([&](int cell) {
+            if (removeCandidates(cell, ALL_CANDIDATES & ~numbers)) flag = true;
+        });
+        return flag;
+    }
 
     /**
-     * Naked Tuple Rule: if there are cells with naked tuple, those numbers can only be placed there, so erase
-     * them from candidate list of other cells in the same row/col/grid.
-     * Example, if a row is like ... | 2,3 | 2,3 | 2,3,7 | 2,3,8 | ... the first two are naked pair. the next two are hidden pair.
-     * delete the hidden pair: ... | 2,3 | 2,3 | 7 | 8 | ...
-     * TC: O(1).. but lot of operations happening here
-     * @param board
+     * Hidden Tuple Rule inside a single unit: if k numbers (k = 2, 3) can only go in the same k cells of the unit,
+     * those cells can't hold anything else.
+     * Example, if 4 and 7 only fit in the first two cells of a row: | 1,4,7 | 2,4,7,9 | ... -> | 4,7 | 4,7 | ...
+     * only numbers with 2 or 3 places in the unit can be part of such a tuple, so usually there are few to combine.
+     * @param u unit number (as in unitCells)
      * @return true if something was modified
-     *
      */
-    bool applyNakedTuple(std::vector<std::vector<char>>& board) {
-        bool flag = false;
+    bool applyHiddenTupleToUnit(const int &u) {
+        const CellSet &unit = unitCells()[u];
+        int numbers[9], count = 0;
+        CellSet places[9];
+        for (uint16_t missing = ALL_CANDIDATES & ~placedIn(u); missing; missing &= missing - 1) {
+            int d = __builtin_ctz(missing);
+            CellSet p = digitCells[d] & unit;
+            int c = p.count();
+            if (c < 2 || c > 3) continue;
+            numbers[count] = d;
+            places[count++] = p;
+        }
 
-        // process each row
-        std::unordered_map<std::unordered_set<char>, std::unordered_set<int>, UnorderedSetHash, UnorderedSetEqual> nakedTupleRow;
-        for (int row = 0; row < 9; row++) {
-            nakedTupleRow.clear();
-            for (int col = 0; col < 9; col++) {
-                if (!cellCandidates[row*9+col].empty()) {
-                    nakedTupleRow[cellCandidates[row*9+col]].insert(row*9+col);
+        bool flag = false;
+        for (int a = 0; a < count; a++) {
+            for (int b = a + 1; b < count; b++) {
+                CellSet pair = places[a] | places[b];
+                uint16_t pairNumbers = (1 << numbers[a]) | (1 << numbers[b]);
+                int c = pair.count();
+                if (c == 2) { // hidden pair
+                    if (keepOnly(pair, pairNumbers)) flag = true;
+                    continue;
                 }
-            }
-            for (const auto& [numbers, indexes] : nakedTupleRow) {
-                if (numbers.size() == indexes.size() && numbers.size() > 1) {
-                    // then this is a naked tuple. Erase these numbers from the entire row except for `indexes`.
-                    for (int col = 0; col < 9; col++) {
-                        int cell = row*9+col;
-                        if (indexes.find(cell) != indexes.end()) continue;
-                        // erase the number in naked tuple from current cell's candidate set.
-                        for (const auto &nt : numbers) {
-                            if (cellCandidates[cell].erase(nt) > 0) flag = true;
-                        }
-                    }
+                if (c != 3) continue;
+                for (int t = b + 1; t < count; t++) {
+                    CellSet triple = pair | places[t];
+                    if (triple.count() == 3 && keepOnly(triple, pairNumbers | (1 << numbers[t]))) flag = true; // hidden triple
                 }
             }
         }
+        return flag;
+    }
 
-        // process each column
-        std::unordered_map<std::unordered_set<char>, std::unordered_set<int>, UnorderedSetHash, UnorderedSetEqual> nakedTupleCol;
-        for (int col = 0; col < 9; col++) {
-            nakedTupleCol.clear();
-            for (int row = 0; row < 9; row++) {
-                if (!cellCandidates[row*9+col].empty()) {
-                    nakedTupleCol[cellCandidates[row*9+col]].insert(row*9+col);
-                }
-            }
-            for (const auto& [numbers, indexes] : nakedTupleCol) {
-                if (numbers.size() == indexes.size() && numbers.size() > 1) {
-                    // then this is a naked tuple. Erase these numbers from the entire col except for `indexes`.
-                    for (int row = 0; row < 9; row++) {
-                        int cell = row*9+col;
-                        if (indexes.find(cell) != indexes.end()) continue;
-                        // erase the number in naked tuple from current cell's candidate set.
-                        for (const auto &nt : numbers) {
-                            if (cellCandidates[cell].erase(nt) > 0) flag = true;
-                        }
-                    }
-                }
-            }
+    /**
+     * Hidden Tuple Rule on every row, col and grid.
+     * TC: O(1), 27 units, each at most C(9,2) + C(9,3) CellSet unions (far fewer in practice)
+     * @return true if something was modified
+     */
+    bool applyHiddenTuple() {
+        bool flag = false;
+        for (int u = 0; u < 27; u++) {
+            if (applyHiddenTupleToUnit(u)) flag = true;
         }
+        return flag;
+    }
 
-        // process each grid
-        std::unordered_map<std::unordered_set<char>, std::unordered_set<int>, UnorderedSetHash, UnorderedSetEqual> nakedTupleGrid;
-        for (int gridrow = 0; gridrow < 3; gridrow++) {
-            for (int gridcol = 0; gridcol < 3; gridcol++) {
-                // process single grid.
-                int gridstart = gridrow*27+gridcol*3;
-                int gridend = gridstart+27;
-                nakedTupleGrid.clear();
-                for (int row = gridstart; row < gridend; row += 9) {
-                    for (int index = row; index < row+3; index++) {
-                        if (!cellCandidates[index].empty()) {
-                            nakedTupleGrid[cellCandidates[index]].insert(index);
-                        }
-                    }
-                }
-                for (const auto& [numbers, indexes] : nakedTupleGrid) {
-                    if (numbers.size() == indexes.size() && numbers.size() > 1) {
-                        // then this is a naked tuple. Erase these numbers from the entire grid except for `indexes`.
-                        for (int row = gridstart; row < gridend; row += 9) {
-                            for (int cell = row; cell < row+3; cell++) {
-                                if (indexes.find(cell) != indexes.end()) continue;
-                                // erase the number in naked tuple from current cell's candidate set.
-                                for (const auto &nt : numbers) {
-                                    if (cellCandidates[cell].erase(nt) > 0) flag = true;
-                                }
-                            }
-                        }
-                    }
-                }
+    /**
+     * checks whether some row/col/grid has a number that is neither placed in it nor a candidate of any of its cells.
+     * such a number can never be placed, so the current configuration has no answer.
+     * TC: O(1), one unitUnions pass + 27 checks
+     * @return true if the configuration is a dead end
+     */
+    bool hasDeadUnit() {
+        uint16_t unions[27];
+        kernel->unitUnions(cellCandidates.data(), unions);
+        for (int i = 0; i < 9; i++) {
+            if ((unions[i] | rowMask[i]) != ALL_CANDIDATES) return true;
+            if ((unions[9 + i] | colMask[i]) != ALL_CANDIDATES) return true;
+            if ((unions[18 + i] | gridMask[i]) != ALL_CANDIDATES) return true;
+        }
+        return false;
+    }
+
+    /**
+     * Naked Tuple Rule inside a single unit (row/col/grid) given by its 9 cell indexes.
+     * if k cells of the unit share exactly the same k candidates, those numbers can only be placed there.
+     * @param unit cell indexes of the unit
+     * @return true if something was modified
+     */
+    bool applyNakedTupleToUnit(const std::array<uint8_t, 9> &unit) {
+        bool flag = false;
+        for (int a = 0; a < 9; a++) {
+            uint16_t numbers = cellCandidates[unit[a]];
+            int size = popcount(numbers);
+            if (size < 2) continue;
+
+            int sameCount = 0;
+            for (int b = 0; b < 9; b++)
+                if (cellCandidates[unit[b]] == numbers) sameCount++;
+            if (sameCount != size) continue;
+
+            // then this is a naked tuple. Erase these numbers from the rest of the unit.
+            for (int b = 0; b < 9; b++) {
+                if (cellCandidates[unit[b]] != numbers && removeCandidates(unit[b], numbers))
+                    flag = true;
             }
         }
+        return flag;
+    }
 
+    /**
+     * Naked Tuple Rule: if there are cells with naked tuple, those numbers can only be placed there, so erase
+     * them from candidate list of other cells in the same row/col/grid.
+     * Example, if a row is like ... | 2,3 | 2,3 | 2,3,7 | 2,3,8 | ... the first two are naked pair. the next two are hidden pair.
+     * delete the hidden pair: ... | 2,3 | 2,3 | 7 | 8 | ...
+     * TC: O(1), Θ(27 * 81)
+     * @return true if something was modified
+     *
+     */
+    bool applyNakedTuple() {
+        bool flag = false;
+        // every row, col and grid
+        for (int u = 0; u < 27; u++) {
+            if (applyNakedTupleToUnit(Board9::unitCells(u))) flag = true;
+        }
         return flag;
     }
 
     /**
-     * the chief function where `rule based` algorithm takes place.
+     * runs one rule if it is enabled, and records in the stats how many candidates it eliminated.
+     * @param apply calls the rule, returns true if something was modified
+     * @return true if something was modified
+     */
+    template <typename F>
+    bool runRule(const Rule &rule, F apply) {
+        if (!ruleEnabled[rule]) return false;
+        const int before = trailSize;
+        if (!apply()) return false;
+        if constexpr (Stats::enabled) stats.rule(rule, eliminatedSince(before));
+        return true;
+    }
+
+    /**
+     * candidate bits removed by the trail entries after `mark`. a placed cell dropping its own candidates is not an
+     * elimination, so the entry right after an assignment doesn't count.
+     * TC: O(trail entries after mark)
+     */
+    long long eliminatedSince(const int &mark) const {
+        std::array<uint16_t, 81> after;
+        std::copy(cellCandidates.begin(), cellCandidates.begin() + 81, after.begin());
+        long long eliminated = 0;
+        // newest first, so `after` holds the mask each entry was changed into
+        for (int i = trailSize - 1; i >= mark; i--) {
+            const TrailEntry &e = trail[i];
+            if (e.kind != TrailEntry::CANDIDATES) continue;
+            const bool ownCell = i > 0 && trail[i - 1].kind == TrailEntry::ASSIGNMENT && trail[i - 1].cell == e.cell;
+            if (!ownCell) eliminated += popcount(e.value & ~after[e.cell]);
+            after[e.cell] = e.value;
+        }
+        return eliminated;
+    }
+
+    static constexpr int SOLVED = -2, DEAD = -1;
+
+    /**
+     * runs the rules until none of them changes anything, then tells what is left to do with the configuration.
      * @param board
-     * @return some board. can be solution board or not.
+     * @return SOLVED, DEAD (this configuration doesn't have answer), or the cell to guess next
      */
-    std::vector<std::vector<char>> ruleBased(std::vector<std::vector<char>>& board) {
+    int propagate(Grid& board) {
         while(true) {
-            if (applyNakedSingle(board)) continue;
-            if (applyNakedTuple(board)) continue;
+            stats.round();
+            if (runRule(NAKED_SINGLE, [&] { return applyNakedSingle(board); })) continue;
+            if (runRule(HIDDEN_SINGLE, [&] { return applyHiddenSingle(board); })) continue;
+            if (runRule(LOCKED_CANDIDATES, [&] { return applyLockedCandidates(); })) continue;
+            if (runRule(NAKED_TUPLE, [&] { return applyNakedTuple(); })) continue;
+            if (runRule(HIDDEN_TUPLE, [&] { return applyHiddenTuple(); })) continue;
             break;
         }
 
         // check if the board is solved only with heuristics.
-        if (isSolved(board)) return board;
+        if (isSolved(board)) return SOLVED;
+
+        if (hasDeadUnit()) return DEAD; // some number has no place left in a row/col/grid.
+
+        // conquer the cell with few candidates first. -1 (= DEAD) if some empty cell has no candidate left.
+        const int cell = findCellWithLeastCandidates();
+        if (cell >= 0) stats.guessPoint(); // found in the buckets, not by an 81-cell scan
+        return cell;
+    }
+
+    /**
+     * the chief function where `rule based` algorithm takes place.
+     * every solution found is counted in solutionCount, and the search stops once solutionLimit of them are found.
+     * @param board filled in place. holds the last solution found if this returns true.
+     * @param depth number of guesses this configuration is built on
+     * @return true if the search stopped because it found solutionLimit solutions.
+     */
+    bool ruleBased(Grid& board, const int &depth) {
+        if (cancel != nullptr && cancel->load(std::memory_order_relaxed)) return false; // another branch already won
+        stats.node(depth);
+
+        int cell = propagate(board);
+        if (cell == SOLVED) return ++solutionCount >= solutionLimit;
+        if (cell == DEAD) return false;
 
         // can't solve by heuristics at this point. do random guess, then backtrack with `ruleBased`
+        if (depth == 0 && parallelSearch) return guessInParallel(board, cell);
+        return guess(board, cell, depth);
+    }
 
-        int cell = findCellWithLeastCandidates(board); // conquer the cell with few candidates first.
-        // save the current candidate
-        auto cellCandidatesBackup = cellCandidates;
-        auto boardBackup = board;
-        auto candidates = cellCandidates[cell];
-        for (const auto candidate : candidates) {
+    /**
+     * tries every candidate of `cell` in turn, running ruleBased on each, and undoes it if it doesn't lead to enough solutions.
+     * @param board
+     * @param cell
+     * @param depth number of guesses the current configuration is built on
+     * @return true if the search stopped because it found solutionLimit solutions.
+     */
+    bool guess(Grid& board, const int &cell, const int &depth) {
+        // remember where the trail is, so we can come back to this state after a wrong guess.
+        const int mark = trailSize;
+        for (uint16_t candidates = cellCandidates[cell]; candidates; candidates &= candidates - 1) {
             // put number
-            auto tempset = cellCandidates[cell];
-            board[cell/9][cell%9] = candidate;
-            putNumber(cell/9, cell%9, candidate);
-
-            // recurse and check if returns a valid board
-            std::vector<std::vector<char>> board_new = ruleBased(board);
-            if (!board_new.empty() && isSolved(board_new))
-                return board_new;
-
-            // erase number to backtrack.
-            board = boardBackup;
-            cellCandidates = cellCandidatesBackup;
+            uint8_t candidate = lowestCandidate(candidates);
+            stats.guess();
+            putNumber(board, cell, candidate);
+
+            // recurse and check if it found enough solutions
+            if (ruleBased(board, depth + 1))
+                return true;
+
+            // undo everything since the guess to backtrack.
+            stats.backtrack();
+            undoTo(board, mark);
         }
 
-        // couldn't find solution. Return empty board.
-        return {};
+        // couldn't find solution.
+        return false;
+    }
+
+    // a configuration some guesses below the first guess point, with its own copy of the whole solver state.
+    struct Branch {
+        BasicHeuristicsBacktrackingSolver solver;
+        Grid board;
+        int cell;  // cell to guess next
+    };
+
+    /**
+     * turns every configuration `splitDepth - level` guesses below the current one into a Branch. dead configurations
+     * are dropped, and a configuration solved while collecting ends the whole search.
+     * @return true if a solution was found while collecting (board holds it)
+     */
+    bool collectBranches(Grid& board, const int &cell, const int &level, std::vector<Branch>& branches) {
+        const int mark = trailSize;
+        for (uint16_t candidates = cellCandidates[cell]; candidates; candidates &= candidates - 1) {
+            stats.guess();
+            putNumber(board, cell, lowestCandidate(candidates));
+            stats.node(level + 1);
+
+            int next = propagate(board);
+            if (next == SOLVED) {
+                solutionCount++;
+                return true;
+            }
+            if (next != DEAD) {
+                if (level + 1 < splitDepth) {
+                    if (collectBranches(board, next, level + 1, branches)) return true;
+                }
+                else {
+                    branches.push_back({*this, board, next});
+                    branches.back().solver.stats.clear(); // counted here already
+                }
+            }
 
+            stats.backtrack();
+            undoTo(board, mark);
+        }
+        return false;
     }
 
-    virtual void solve(SudokuBoard& sb) override {
-        resourceClear();
-        auto originalBoardSave = sb.getOriginalBoard();
+    /**
+     * parallel version of the guessing part, used at the first guess point when parallel mode is on (solve() only).
+     * the configurations splitDepth guesses below it become branches, each with its own copy of the solver, and
+     * parallelThreads threads (this one included) take branches in order until one of them finds the solution.
+     * that one raises the shared cancel flag, so the others stop at their next node.
+     * @param board in: the configuration at the first guess point. out: the solution, if found.
+     * @param cell cell to guess
+     * @return true if the solution was found.
+     */
+    bool guessInParallel(Grid& board, const int &cell) {
+        std::vector<Branch> branches;
+        if (collectBranches(board, cell, 0, branches)) return true;
+        if (branches.empty()) return false;
+
+        std::atomic<bool> stop(false);
+        std::atomic<size_t> next(0);
+        std::atomic<int> winner(-1);
+        auto work = [&]() {
+            size_t i;
+            while (!stop.load(std::memory_order_relaxed) && (i = next.fetch_add(1, std::memory_order_relaxed)) < branches.size()) {
+                Branch &b = branches[i];
+                b.solver.cancel = &stop;
+                if (b.solver.guess(b.board, b.cell, splitDepth)) {
+                    int none = -1;
+                    if (winner.compare_exchange_strong(none, (int) i)) stop.store(true, std::memory_order_relaxed);
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        unsigned threads = (unsigned) std::min<size_t>(parallelThreads, branches.size());
+        for (unsigned t = 1; t < threads; t++) workers.emplace_back(work);
+        work();
+        for (auto &w : workers) w.join();
+
+        for (const Branch &b : branches) stats.add(b.solver.stats);
+        if (winner.load() == -1) return false;
+        board = branches[winner.load()].board;
+        solutionCount = 1;
+        return true;
+    }
 
-        Timer t;
-        auto& board = sb.getOriginalBoard();
+    /**
+     * places the clues of `board` and runs the rule based search until `limit` solutions are found or
+     * the search space is exhausted.
+     * @param board in: the puzzle. out: the last solution found, if any.
+     * @param limit
+     * @param parallel race branches at the first guess point if setParallel() asked for it (solve() only)
+     * @return number of solutions found, at most `limit`.
+     */
+    long long search(Grid& board, long long limit, bool parallel = false) {
+        setBoard(board);
+        solutionLimit = limit;
+        parallelSearch = parallel && parallelThreads > 1;
 
-        // set the current configuration of the board.
+        // perform the rulebased backtracking algorithm:
+        ruleBased(board, 0);
+        return solutionCount;
+    }
+
+    /**
+     * forgets the previous board and puts every number of `board` (clues, or clues plus earlier guesses).
+     * @param board
+     */
+    void setBoard(Grid& board) {
+        resourceClear();
         for (int i = 0; i <= 80; i++) {
-            int row = i / 9, col = i % 9;
-            if (board[row][col] == '.') continue;
-            putNumber(row, col, board[row][col]);
+            if (board[i] == 0) continue;
+            putNumber(board, i, board[i]);
         }
-        // perform the rulebased backtracking algorithm:
-        auto result = ruleBased(board);
-        if (!result.empty()) {
-            sb.setSolvedBoard(std::move(result));
+    }
+
+    // current trail size, to pass to undoTo() later
+    int trailMark() const {
+        return trailSize;
+    }
+    // candidate mask of the cell (bit n-1 = number n)
+    uint16_t getCandidates(const int &cell) const {
+        return cellCandidates[cell];
+    }
+
+    virtual void solve(SudokuBoard& sb) override {
+        Timer t;
+        Grid board = sb.getOriginalGrid();
+
+        if (search(board, 1, true) == 1) {
+            sb.setSolvedGrid(board);
             sb.setElapsedTime(t.end());
-            sb.setOriginalBoard(std::move(originalBoardSave));
             sb.setAlgorithmUsed("heuristics backtracking");
+            if constexpr (Stats::enabled) sb.setStats(stats.get());
         }
         else {
             // if couldn't solve the board, the board configuration was wrong, so we need to get another board.
@@ -402,14 +792,46 @@ public:
         }
     }
 
-    virtual void resourceClear() override {
-        for (int i = 0; i <= 80; i++) { // intialize every cell's set.
-            cellCandidates[i] = std::unordered_set<char>{'1', '2', '3', '4', '5', '6', '7', '8', '9'};
-        }
+    virtual long long countSolutions(const SudokuBoard& sb, long long limit = 2) override {
+        Grid board = sb.getOriginalGrid();
+        return search(board, limit);
     }
 
+    virtual std::unique_ptr<SudokuSolver> clone() const override {
+        auto solver = std::make_unique<BasicHeuristicsBacktrackingSolver>();
+        solver->setKernel(*kernel);
+        solver->ruleEnabled = ruleEnabled;
+        solver->parallelThreads = parallelThreads;
+        solver->splitDepth = splitDepth;
+        return solver;
+    }
+
+    // each of the batch workers races its branches on at most hardware_concurrency / workers threads
+    virtual std::unique_ptr<SudokuSolver> cloneForBatch(const unsigned &workers) const override {
+        auto solver = clone();
+        auto *copy = static_cast<BasicHeuristicsBacktrackingSolver *>(solver.get());
+        const unsigned share = std::max(1u, std::thread::hardware_concurrency() / std::max(1u, workers));
+        copy->parallelThreads = std::min(parallelThreads, share);
+        return solver;
+    }
+
+    virtual void resourceClear() override {
+        cellCandidates.fill(0); // padding lanes stay 0
+        std::fill(cellCandidates.begin(), cellCandidates.begin() + 81, ALL_CANDIDATES); // every number is possible in every cell.
+        rowMask.fill(0), colMask.fill(0), gridMask.fill(0);
+        trailSize = 0;
+        cellsByCount.fill(CellSet());
+        cellsByCount[9] = emptyCells = CellSet::all();
+        digitCells.fill(CellSet::all());
+        stats.clear();
+        solutionCount = 0;
+        solutionLimit = 1;
+        parallelSearch = false;
+    }
 
 };
 
+using HeuristicsBacktrackingSolver = BasicHeuristicsBacktrackingSolver<>;
+using HeuristicsBacktrackingSolverWithStats = BasicHeuristicsBacktrackingSolver<CollectStats>;
 
 #endif //HEURISTICSBACKTRACKINGSOLVER_H
@@ -0,0 +1,64 @@
+//
+// Fixed size map that forgets the least recently used entry, for remembering solved boards.
+//
+
+#ifndef LRUCACHE_H
+#define LRUCACHE_H
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * hash map plus a recency list: find() and put() are O(1), and putting a new key into a full cache evicts the entry
+ * that was found or put the longest time ago. keys are compared in full, the hash only picks the bucket, so two keys
+ * with the same hash never get each other's values.
+ *
+ * not thread safe: use it from one thread.
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache {
+    using Entry = std::pair<Key, Value>;
+
+    size_t capacity;
+    std::list<Entry> entries;  // most recently used first
+    std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> index;
+
+public:
+    explicit LruCache(const size_t &capacity) : capacity(capacity < 1 ? 1 : capacity) {}
+
+    /**
+     * TC: O(1)
+     * @return the value of `key`, now the most recently used, or nullptr. valid until the next put().
+     */
+    const Value* find(const Key &key) {
+        auto it = index.find(key);
+        if (it == index.end()) return nullptr;
+        entries.splice(entries.begin(), entries, it->second);
+        return &it->second->second;
+    }
+
+    // adds or replaces `key`, as the most recently used. evicts the least recently used entry if full.
+    void put(const Key &key, Value value) {
+        auto it = index.find(key);
+        if (it != index.end()) {
+            it->second->second = std::move(value);
+            entries.splice(entries.begin(), entries, it->second);
+            return;
+        }
+        if (entries.size() == capacity) {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+        entries.emplace_front(key, std::move(value));
+        index.emplace(key, entries.begin());
+    }
+
+    size_t size() const {
+        return entries.size();
+    }
+};
+
+#endif //LRUCACHE_H
@@ -0,0 +1,158 @@
+//
+// Long-lived Tesseract engines on worker threads, for recognizing many cell images at once.
+//
+
+#ifndef OCRENGINEPOOL_H
+#define OCRENGINEPOOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+#include <tesseract/baseapi.h>
+
+/**
+ * one initialized tesseract::TessBaseAPI per worker thread, created once and reused for every board.
+ * Init() loads the whole LSTM model, which is far more expensive than recognizing a cell, and an engine can only be
+ * used by one thread at a time, so each worker owns its engine for the lifetime of the pool.
+ *
+ * recognize() hands a batch of cell images to all workers. they take cells one at a time from a shared counter, so
+ * a board parse takes about (cells / workers) Recognize calls of wall time instead of all of them in a row.
+ */
+class OcrEnginePool {
+public:
+    /**
+     * starts `threads` workers (0 = one per core), each with an engine initialized for `language`.
+     * check ok() afterwards: if some engine failed to initialize, the pool is empty.
+     */
+    explicit OcrEnginePool(unsigned threads = 0, const char* language = "eng") {
+        unsigned n = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 0; i < n; i++) {
+            auto engine = std::make_unique<tesseract::TessBaseAPI>();
+            if (engine->Init(NULL, language, tesseract::OEM_LSTM_ONLY)) {
+                std::cerr << "Could not initialize tesseract.\n";
+                for (auto &e : engines) e->End();
+                engines.clear();
+                return;
+            }
+            engine->SetPageSegMode(tesseract::PSM_SINGLE_CHAR);
+            engines.push_back(std::move(engine));
+        }
+        for (unsigned i = 0; i < n; i++) workers.emplace_back(&OcrEnginePool::run, this, i);
+    }
+
+    ~OcrEnginePool() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto &w : workers) w.join();
+        for (auto &e : engines) e->End();
+    }
+
+    OcrEnginePool(const OcrEnginePool&) = delete;
+    OcrEnginePool& operator=(const OcrEnginePool&) = delete;
+
+    bool ok() const {
+        return !engines.empty();
+    }
+    size_t size() const {
+        return engines.size();
+    }
+
+    /**
+     * recognizes one digit per cell image, on all workers. blocks until the whole batch is done.
+     * one batch at a time: call it from a single thread.
+     * @param cells 8-bit single channel cell images. empty ones are skipped (digit 0).
+     * @param digits out: 1-9 for cells read as that digit with confidence above `minConfidence`, 0 otherwise
+     * @param minConfidence tesseract symbol confidence (0-100) a digit needs to be accepted
+     */
+    void recognize(const std::vector<cv::Mat>& cells, std::vector<uint8_t>& digits, const float &minConfidence = 95.0f) {
+        digits.assign(cells.size(), 0);
+        if (cells.empty() || !ok()) return;
+        std::unique_lock<std::mutex> guard(lock);
+        batchCells = &cells;
+        batchDigits = digits.data();
+        batchConfidence = minConfidence;
+        next = 0;
+        finishedWorkers = 0;
+        generation++;
+        wake.notify_all();
+        finished.wait(guard, [&] { return finishedWorkers == workers.size(); });
+        batchCells = nullptr;
+        batchDigits = nullptr;
+    }
+
+private:
+    std::vector<std::unique_ptr<tesseract::TessBaseAPI>> engines;  // engines[i] belongs to workers[i]
+    std::vector<std::thread> workers;
+
+    // the current batch. set under `lock`, read by the workers after they see the new generation.
+    std::mutex lock;
+    std::condition_variable wake, finished;
+    long long generation = 0;
+    size_t finishedWorkers = 0;
+    bool stopping = false;
+    const std::vector<cv::Mat>* batchCells = nullptr;
+    uint8_t* batchDigits = nullptr;
+    float batchConfidence = 95.0f;
+    std::atomic<size_t> next{0};  // next cell of the batch to take
+
+    // the last digit tesseract reads in the cell with enough confidence, 0 if none.
+    static uint8_t recognizeCell(tesseract::TessBaseAPI &tess, const cv::Mat &cell, const float &minConfidence) {
+        uint8_t digit = 0;
+        tess.SetImage(cell.data, cell.cols, cell.rows, 1, cell.step);
+        tess.Recognize(0);
+        tesseract::ResultIterator* ri = tess.GetIterator();
+        if (ri == nullptr) return 0;
+        do {
+            const char* symbol = ri->GetUTF8Text(tesseract::RIL_SYMBOL);
+            float conf = ri->Confidence(tesseract::RIL_SYMBOL);
+            if (symbol != nullptr && std::isdigit(symbol[0]) && symbol[0] != '0' && conf > minConfidence) {
+                digit = symbol[0] - '0';
+            }
+            delete[] symbol;
+        } while (ri->Next(tesseract::RIL_SYMBOL));
+        delete ri;
+        return digit;
+    }
+
+    void run(const unsigned &id) {
+        tesseract::TessBaseAPI &tess = *engines[id];
+        long long seen = 0;
+        while (true) {
+            const std::vector<cv::Mat>* cells;
+            uint8_t* digits;
+            float minConfidence;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                wake.wait(guard, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+                cells = batchCells;
+                digits = batchDigits;
+                minConfidence = batchConfidence;
+            }
+            for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < cells->size();) {
+                const cv::Mat &cell = (*cells)[i];
+                if (!cell.empty()) digits[i] = recognizeCell(tess, cell, minConfidence);
+            }
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                finishedWorkers++;
+            }
+            finished.notify_one();
+        }
+    }
+};
+
+#endif //OCRENGINEPOOL_H
@@ -0,0 +1,182 @@
+//
+// Scoped, hierarchical stage timing for the camera frame loop (and anything else that wants a per-stage breakdown).
+//
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(PROFILER_USE_TSC) && (defined(__x86_64__) || defined(__i386__))
+#define PROFILER_TSC 1
+#include <x86intrin.h>
+#endif
+
+/**
+ * tick source of the profiler. steady_clock by default. Build with PROFILER_USE_TSC (cmake -DPROFILER_USE_TSC=ON)
+ * to read the CPU time stamp counter instead, which is a single instruction. ticks are converted to seconds by
+ * comparing against steady_clock over the whole reporting window, so no calibration pause is needed.
+ * (assumes an invariant TSC, which every x86 CPU of the last decade has)
+ */
+struct ProfilerClock {
+    static uint64_t now() {
+#ifdef PROFILER_TSC
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+    static const char* name() {
+#ifdef PROFILER_TSC
+        return "tsc";
+#else
+        return "steady_clock";
+#endif
+    }
+};
+
+/**
+ * Tree of named stages. Stages are opened with ProfileScope; a scope opened while another one is open becomes its
+ * child, so the same name under different parents is a different stage. Each stage keeps count/total/max of the
+ * current reporting window.
+ *
+ * entering a scope is a lookup among the children of the open stage (a handful, compared by pointer first), and
+ * two clock reads. Stage names must be string literals (or outlive the profiler).
+ * Not thread safe: use one Profiler per thread.
+ */
+class Profiler {
+public:
+    struct Stage {
+        const char* name;
+        int parent;
+        int depth;
+        std::vector<int> children;
+        long long count = 0;
+        uint64_t total = 0, max = 0;  // in ticks
+    };
+
+    Profiler() {
+        stages.push_back({"root", -1, -1, {}});
+        resetWindow();
+    }
+
+    /**
+     * opens stage `name` under the currently open one (creating it the first time). Use ProfileScope instead.
+     * @return index of the stage, to pass to leave()
+     */
+    int enter(const char* name) {
+        int parent = open;
+        int found = -1;
+        for (int c : stages[parent].children) {
+            if (stages[c].name == name || !strcmp(stages[c].name, name)) {
+                found = c;
+                break;
+            }
+        }
+        if (found == -1) {
+            found = (int) stages.size();
+            stages.push_back({name, parent, stages[parent].depth + 1, {}});
+            stages[parent].children.push_back(found);
+        }
+        open = found;
+        return found;
+    }
+
+    // closes stage `stage` that took `ticks`, reopening its parent.
+    void leave(const int &stage, const uint64_t &ticks) {
+        Stage &s = stages[stage];
+        s.count++;
+        s.total += ticks;
+        s.max = std::max(s.max, ticks);
+        open = s.parent;
+    }
+
+    // seconds since the window started (i.e. since construction or the last resetWindow()).
+    double windowSeconds() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - windowStart).count();
+    }
+
+    // starts a new reporting window: zeroes every counter, keeps the stage tree.
+    void resetWindow() {
+        for (Stage &s : stages) s.count = 0, s.total = 0, s.max = 0;
+        windowStart = std::chrono::steady_clock::now();
+        windowStartTicks = ProfilerClock::now();
+    }
+
+    /**
+     * one line per stage in tree order: indented name, count, mean and max in ms, and share of the parent's time.
+     * stages that did not run in this window are skipped.
+     */
+    std::vector<std::string> lines() const {
+        std::vector<std::string> out;
+        double msPerTick = secondsPerTick() * 1e3;
+        appendLines(0, msPerTick, out);
+        return out;
+    }
+
+    void print(std::ostream &out) const {
+        out << "---- stage timings over " << windowSeconds() << " s (" << ProfilerClock::name() << ") ----" << std::endl;
+        for (const std::string &line : lines()) out << line << std::endl;
+    }
+
+private:
+    // stages[0] is the root, which is never timed
+    std::vector<Stage> stages;
+    int open = 0;
+    std::chrono::steady_clock::time_point windowStart;
+    uint64_t windowStartTicks;
+
+    double secondsPerTick() const {
+#ifdef PROFILER_TSC
+        uint64_t ticks = ProfilerClock::now() - windowStartTicks;
+        return ticks ? windowSeconds() / ticks : 0;
+#else
+        return 1e-9;
+#endif
+    }
+
+    void appendLines(const int &stage, const double &msPerTick, std::vector<std::string> &out) const {
+        const Stage &s = stages[stage];
+        for (int c : s.children) {
+            const Stage &child = stages[c];
+            if (child.count == 0) continue;
+            char buf[160];
+            double mean = child.total * msPerTick / child.count;
+            double max = child.max * msPerTick;
+            if (stage == 0) {
+                snprintf(buf, sizeof(buf), "%*s%-*s %6lld x %8.3f ms (max %8.3f)", child.depth * 2, "",
+                         24 - child.depth * 2, child.name, child.count, mean, max);
+            } else {
+                double share = s.total ? 100.0 * child.total / s.total : 0;
+                snprintf(buf, sizeof(buf), "%*s%-*s %6lld x %8.3f ms (max %8.3f) %5.1f%%", child.depth * 2, "",
+                         24 - child.depth * 2, child.name, child.count, mean, max, share);
+            }
+            out.emplace_back(buf);
+            appendLines(c, msPerTick, out);
+        }
+    }
+};
+
+// times the enclosing block as stage `name` of `profiler`.
+class ProfileScope {
+    Profiler &profiler;
+    int stage;
+    uint64_t start;
+public:
+    ProfileScope(Profiler &p, const char* name) : profiler(p), stage(p.enter(name)), start(ProfilerClock::now()) {}
+    ~ProfileScope() {
+        profiler.leave(stage, ProfilerClock::now() - start);
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+#endif //PROFILER_H
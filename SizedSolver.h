@@ -0,0 +1,263 @@
+//
+// Bitmask backtracking solver for any board size from 4x4 to 25x25, specialized at compile time.
+//
+
+#ifndef SIZEDSOLVER_H
+#define SIZEDSOLVER_H
+
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "BoardShape.h"
+#include "SolveStats.h"
+#include "SudokuBoard.h"
+#include "SudokuSolver.h"
+#include "Timer.h"
+
+/**
+ * backtracking on bitmasks, templated on the box size. which numbers each row/col/box already holds is one Mask
+ * (uint16_t up to 16x16, uint32_t for 25x25), the candidates of a cell are ALL & ~(row | col | box), and the
+ * row/col/box of a cell come from the BoardShape tables, so there is no division anywhere in the search.
+ *
+ * the next cell to fill is a forced one if there is any (a cell with one candidate, or a number with one place left
+ * in a unit), otherwise the empty cell with the fewest candidates. without that, bigger boards are hopeless: the search
+ * would branch on the first empty cell of a 25x25 board with up to 25 choices.
+ * the recursion is an explicit stack, and the state is fixed size, so search() never allocates.
+ */
+template <int BOX, typename Stats = NoStats>
+class BasicSizedSolver {
+public:
+    using Shape = BoardShape<BOX>;
+    using Mask = typename Shape::Mask;
+    using Index = typename Shape::Index;
+    using Grid = typename Shape::Grid;
+    static constexpr int N = Shape::N;
+    static constexpr int CELLS = Shape::CELLS;
+
+private:
+    std::array<Mask, N> rowMask, colMask, boxMask;
+    // empty cells. the first k are filled (in that order) at depth k, the rest are still to pick from
+    std::array<Index, CELLS> emptyCells;
+    int emptyCount;
+    // index of every empty cell in emptyCells, -1 for clues. so at depth k, "position[cell] < k" means not empty
+    std::array<int, CELLS> position;
+    // per depth: candidates not tried yet, and the number currently placed (0 if none)
+    std::array<Mask, CELLS> untried;
+    std::array<uint8_t, CELLS> placed;
+    // per depth: the cell had more than one candidate, so its placements are guesses (only kept for the stats)
+    std::array<bool, CELLS> branching;
+    long long solutionCount;
+    Stats stats;
+
+    Mask candidates(const int &cell) const {
+        return Shape::ALL & ~(rowMask[Shape::rowOf(cell)] | colMask[Shape::colOf(cell)] | boxMask[Shape::boxOf(cell)]);
+    }
+
+    void insert(const int &cell, const uint8_t &n) {
+        Mask bit = (Mask) (1u << (n - 1));
+        rowMask[Shape::rowOf(cell)] |= bit;
+        colMask[Shape::colOf(cell)] |= bit;
+        boxMask[Shape::boxOf(cell)] |= bit;
+    }
+
+    void erase(const int &cell, const uint8_t &n) {
+        Mask bit = (Mask) ~(1u << (n - 1));
+        rowMask[Shape::rowOf(cell)] &= bit;
+        colMask[Shape::colOf(cell)] &= bit;
+        boxMask[Shape::boxOf(cell)] &= bit;
+    }
+
+    Mask unitMask(const int &unit) const {
+        return unit < N ? rowMask[unit] : unit < 2 * N ? colMask[unit - N] : boxMask[unit - 2 * N];
+    }
+
+    void moveTo(int k, int i) {  // by value: i is often position[...], which this changes
+        std::swap(emptyCells[k], emptyCells[i]);
+        position[emptyCells[k]] = k;
+        position[emptyCells[i]] = i;
+    }
+
+    /**
+     * picks the cell to fill at depth k and moves it to emptyCells[k]:
+     *   - the empty cell with the fewest candidates, if it has at most one.
+     *   - otherwise a number that fits in only one cell of some unit (hidden single), in that cell.
+     *   - otherwise the empty cell with the fewest candidates.
+     * the unit scan is what makes 16x16 and 25x25 boards practical, where cells have many candidates long before any
+     * of them is down to one.
+     * TC: O(empty cells + 3*N*N)
+     * @return the candidates to try in that cell, 0 if the board is dead (a cell with none, or a number with no cell)
+     */
+    Mask pickCell(const int &k) {
+        int best = k, bestCount = N + 1;
+        Mask bestMask = 0;
+        for (int i = k; i < emptyCount; i++) {
+            Mask m = candidates(emptyCells[i]);
+            int count = __builtin_popcount(m);
+            if (count < bestCount) {
+                best = i, bestCount = count, bestMask = m;
+                if (count <= 1) break;
+            }
+        }
+        if (bestCount > 1) {
+            for (int u = 0; u < Shape::UNITS; u++) {
+                // numbers that fit in at least one / at least two empty cells of the unit
+                Mask once = 0, twice = 0;
+                for (int cell : Shape::unitCells(u)) {
+                    if (position[cell] < k) continue;  // filled
+                    Mask m = candidates(cell);
+                    twice |= once & m;
+                    once |= m;
+                }
+                Mask missing = Shape::ALL & ~unitMask(u);
+                if (missing & ~once) return 0;  // a number that fits nowhere
+                Mask single = once & ~twice;
+                if (single == 0) continue;
+                single &= -single;
+                for (int cell : Shape::unitCells(u)) {
+                    if (position[cell] >= k && (candidates(cell) & single)) {
+                        moveTo(k, position[cell]);
+                        return single;
+                    }
+                }
+            }
+        }
+        moveTo(k, best);
+        return bestMask;
+    }
+
+public:
+    BasicSizedSolver() {
+        clear();
+    }
+
+    void clear() {
+        rowMask.fill(0), colMask.fill(0), boxMask.fill(0);
+        emptyCount = 0;
+        solutionCount = 0;
+        stats.clear();
+    }
+
+    /**
+     * searches until `limit` solutions are found.
+     * TC: exponential in the number of empty cells worst case
+     * @param board board to fill. holds the last solution found if `limit` solutions were found, otherwise the clues.
+     * @param limit
+     * @return number of solutions found, at most `limit`. 0 if two clues clash or a clue is out of range.
+     */
+    long long search(Grid &board, const long long &limit = 1) {
+        clear();
+        for (int cell = 0; cell < CELLS; cell++) {
+            uint8_t n = board[cell];
+            position[cell] = -1;
+            if (n == 0) {
+                position[cell] = emptyCount;
+                emptyCells[emptyCount++] = (Index) cell;
+                continue;
+            }
+            if (n > N || !(candidates(cell) & (1u << (n - 1)))) return 0;
+            insert(cell, n);
+        }
+
+        int k = 0;  // depth, i.e. how many of emptyCells are filled
+        bool descend = true;
+        while (k >= 0) {
+            if (descend) {
+                if (k == emptyCount) {  // solution found
+                    if (++solutionCount >= limit) break;  // the board keeps the solution
+                    k--, descend = false;
+                    continue;
+                }
+                Mask m = pickCell(k);
+                if (m == 0) {  // some cell has nothing left
+                    k--, descend = false;
+                    continue;
+                }
+                stats.node(k + 1);
+                untried[k] = m;
+                placed[k] = 0;
+                if constexpr (Stats::enabled) branching[k] = (m & (m - 1)) != 0;
+            }
+
+            int cell = emptyCells[k];
+            if (placed[k] != 0) {  // take back the number tried before
+                if constexpr (Stats::enabled) {
+                    if (branching[k]) stats.backtrack();
+                }
+                erase(cell, placed[k]);
+                board[cell] = 0;
+            }
+            if (untried[k] == 0) {
+                k--, descend = false;
+                continue;
+            }
+            uint8_t n = (uint8_t) (__builtin_ctz(untried[k]) + 1);
+            untried[k] &= untried[k] - 1;
+            if constexpr (Stats::enabled) {
+                if (branching[k]) stats.guess();  // more than one choice here
+            }
+            insert(cell, n);
+            board[cell] = n;
+            placed[k] = n;
+            k++, descend = true;
+        }
+        return solutionCount;
+    }
+
+    bool solve(Grid &board) {
+        return search(board, 1) == 1;
+    }
+
+    long long countSolutions(Grid board, const long long &limit = 2) {
+        return search(board, limit);
+    }
+
+    const Stats& getStats() const {
+        return stats;
+    }
+};
+
+template <int BOX>
+using SizedSolver = BasicSizedSolver<BOX>;
+
+/**
+ * the 9x9 instance of BasicSizedSolver as a SudokuSolver, so the camera app and the tools can use it.
+ * (a 9x9 Grid is the same type as BoardShape<3>::Grid, so boards are passed as they are)
+ */
+template <typename Stats = NoStats>
+class BasicBitmaskSolver : public SudokuSolver {
+    BasicSizedSolver<3, Stats> solver;
+
+public:
+    virtual void solve(SudokuBoard &sb) override {
+        Timer t;
+        Grid board = sb.getOriginalGrid();
+        if (solver.solve(board)) {
+            sb.setElapsedTime(t.end());
+            sb.setSolvedGrid(board);
+            sb.setAlgorithmUsed("bitmask backtracking");
+            if constexpr (Stats::enabled) sb.setStats(solver.getStats().get());
+        } else {
+            sb.setHasBoard(false);
+        }
+    }
+
+    virtual long long countSolutions(const SudokuBoard &sb, long long limit = 2) override {
+        return solver.countSolutions(sb.getOriginalGrid(), limit);
+    }
+
+    virtual std::unique_ptr<SudokuSolver> clone() const override {
+        return std::make_unique<BasicBitmaskSolver>();
+    }
+
+    virtual void resourceClear() override {
+        solver.clear();
+    }
+};
+
+using BitmaskSolver = BasicBitmaskSolver<>;
+using BitmaskSolverWithStats = BasicBitmaskSolver<CollectStats>;
+
+#endif //SIZEDSOLVER_H
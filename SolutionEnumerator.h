@@ -0,0 +1,232 @@
+//
+// Parallel exhaustive solution counting with work stealing.
+//
+
+#ifndef SOLUTIONENUMERATOR_H
+#define SOLUTIONENUMERATOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "HeuristicsBacktrackingSolver.h"
+#include "SudokuBoard.h"
+#include "Timer.h"
+
+/**
+ * Counts every solution of a board (up to a limit) on many threads, e.g. to validate generated puzzles or to see how
+ * far off a misread OCR grid is. Sparse grids have huge, very unbalanced search trees, so work is shared by stealing:
+ *
+ *   - a task is a subtree of the search, stored as the grid at its root (81 bytes, cheap to move between threads).
+ *     a worker rebuilds the solver state from it with setBoard() and searches the subtree depth first with the
+ *     HeuristicsBacktrackingSolver rules, undoing guesses with the trail as usual.
+ *   - every worker has its own deque. an idle worker posts one request for work. a busy worker at a guess point with
+ *     more than one candidate left claims a request (CAS on the counter) and pushes one of its later candidates to
+ *     the back of its deque, one task per request, so one hungry thread doesn't make every busy one split at once.
+ *     a worker pops from the back (depth first, hot state), thieves steal from the front.
+ *   - an idle worker steals from random victims, so no single deque becomes the hot spot. it takes its request back
+ *     when it finds work on its own, and posts a new one when every request was served but it's still empty handed.
+ *     after SPIN_ROUNDS failed rounds it sleeps between rounds instead of spinning.
+ *   - each worker counts into its own counter; they are summed at the end. with a limit, workers publish their count
+ *     every FLUSH_EVERY solutions (every solution if the limit is smaller) and everyone stops once the total reaches
+ *     the limit.
+ *
+ * nothing is shared per node except reading the request counter, which is why it should scale with the core count as
+ * long as the tree is big enough to split. that is not measured yet (it was written on a 1 core machine):
+ * `sudoku_cli -c 0 -t N -v` counts a corpus this way and prints the time, to compare -t 1 against -t N.
+ */
+class SolutionEnumerator {
+public:
+    // totals of the last count()
+    struct Result {
+        long long solutions = 0;   // min(number of solutions, limit)
+        long long tasks = 0;       // subtrees handed out (the root included)
+        long long steals = 0;      // tasks taken from another worker's deque
+        unsigned threads = 0;
+        double seconds = 0;
+    };
+
+    // threads = 0 uses one per core.
+    explicit SolutionEnumerator(unsigned threads = 0)
+        : threads(threads ? threads : std::max(1u, std::thread::hardware_concurrency())) {
+    }
+
+    /**
+     * counts the solutions of `puzzle`, stopping once `limit` are found.
+     * @return min(number of solutions, limit), with work stealing totals
+     */
+    Result count(const Grid &puzzle, long long limit = LLONG_MAX) {
+        Timer t;
+        workers.clear();
+        for (unsigned i = 0; i < threads; i++) workers.push_back(std::make_unique<Worker>(i));
+        this->limit = limit;
+        flushEvery = limit < FLUSH_EVERY ? 1 : FLUSH_EVERY;
+        pending = 1;
+        requests = 0;
+        published = 0;
+        stop = false;
+        workers[0]->tasks.push_back(puzzle);
+
+        std::vector<std::thread> pool;
+        for (unsigned i = 1; i < threads; i++) pool.emplace_back(&SolutionEnumerator::run, this, i);
+        run(0);
+        for (auto &th : pool) th.join();
+
+        Result r;
+        for (auto &w : workers) {
+            r.solutions += w->solutions;
+            r.tasks += w->tasks_done;
+            r.steals += w->steals;
+        }
+        r.solutions = std::min(r.solutions, limit);
+        r.threads = threads;
+        r.seconds = t.end();
+        return r;
+    }
+
+    long long count(const SudokuBoard &sb, long long limit = LLONG_MAX) {
+        return count(sb.getOriginalGrid(), limit).solutions;
+    }
+
+    unsigned getThreads() const {
+        return threads;
+    }
+
+private:
+    // solutions a worker counts before adding them to the shared total (only matters with a limit)
+    static constexpr long long FLUSH_EVERY = 1024;
+    // failed steal rounds an idle worker spins (yields) through before it sleeps IDLE_SLEEP between rounds
+    static constexpr int SPIN_ROUNDS = 64;
+    static constexpr std::chrono::microseconds IDLE_SLEEP{100};
+
+    struct alignas(64) Worker {
+        std::mutex lock;
+        std::deque<Grid> tasks;  // back: own end, front: stolen from
+        HeuristicsBacktrackingSolver solver;
+        std::minstd_rand rng;
+        long long solutions = 0, unpublished = 0, tasks_done = 0, steals = 0;
+
+        explicit Worker(unsigned id) : rng(id * 7919 + 1) {}
+    };
+
+    unsigned threads;
+    std::vector<std::unique_ptr<Worker>> workers;
+    long long limit = LLONG_MAX;
+    long long flushEvery = FLUSH_EVERY;
+    std::atomic<long long> pending{0};    // tasks pushed but not finished yet. 0 means the whole tree is done
+    std::atomic<int> requests{0};         // tasks asked for by idle workers, not handed out yet
+    std::atomic<long long> published{0};  // solutions flushed by the workers, to check the limit
+    std::atomic<bool> stop{false};
+
+    bool popOwn(Worker &w, Grid &task) {
+        std::lock_guard<std::mutex> guard(w.lock);
+        if (w.tasks.empty()) return false;
+        task = w.tasks.back();
+        w.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(Worker &w, Grid &task) {
+        for (unsigned attempt = 0; attempt < threads; attempt++) {
+            Worker &victim = *workers[w.rng() % threads];
+            if (&victim == &w) continue;
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (victim.tasks.empty()) continue;
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            w.steals++;
+            return true;
+        }
+        return false;
+    }
+
+    void push(Worker &w, const Grid &task) {
+        pending.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> guard(w.lock);
+        w.tasks.push_back(task);
+    }
+
+    void foundSolution(Worker &w) {
+        w.solutions++;
+        if (limit == LLONG_MAX || ++w.unpublished < flushEvery) return;
+        if (published.fetch_add(w.unpublished) + w.unpublished >= limit) stop = true;
+        w.unpublished = 0;
+    }
+
+    // takes one request off the counter, if there is one. busy workers call it to serve a request, idle ones to
+    // take theirs back.
+    bool claimRequest() {
+        int r = requests.load(std::memory_order_relaxed);
+        while (r > 0) {
+            if (requests.compare_exchange_weak(r, r - 1, std::memory_order_relaxed)) return true;
+        }
+        return false;
+    }
+
+    void run(const unsigned &id) {
+        Worker &w = *workers[id];
+        Grid task;
+        bool hungry = false;
+        int misses = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            if (popOwn(w, task) || steal(w, task)) {
+                if (hungry) claimRequest(), hungry = false;  // someone else's task may already be on its way
+                misses = 0;
+                w.tasks_done++;
+                w.solver.setBoard(task);
+                explore(w, task);
+                pending.fetch_sub(1, std::memory_order_acq_rel);
+                continue;
+            }
+            if (pending.load(std::memory_order_acquire) == 0) break; // the whole tree is done
+            // nothing to do right now: ask for one task (again, if the last one went to another thief), and look again
+            if (!hungry || requests.load(std::memory_order_relaxed) == 0) {
+                requests.fetch_add(1, std::memory_order_relaxed);
+                hungry = true;
+            }
+            if (++misses < SPIN_ROUNDS) std::this_thread::yield();
+            else std::this_thread::sleep_for(IDLE_SLEEP);
+        }
+        if (hungry) claimRequest();
+        // publish what's left, so the limit check of the others sees it (the result sums the workers anyway)
+        published.fetch_add(w.unpublished);
+        w.unpublished = 0;
+    }
+
+    // depth first count of the subtree at the current state of w.solver. board is restored on return.
+    void explore(Worker &w, Grid &board) {
+        if (stop.load(std::memory_order_relaxed)) return;
+        HeuristicsBacktrackingSolver &solver = w.solver;
+        int cell = solver.propagate(board);
+        if (cell == HeuristicsBacktrackingSolver::SOLVED) {
+            foundSolution(w);
+            return;
+        }
+        if (cell == HeuristicsBacktrackingSolver::DEAD) return;
+
+        const int mark = solver.trailMark();
+        for (uint16_t candidates = solver.getCandidates(cell); candidates; candidates &= candidates - 1) {
+            // one of the candidates after this one per request goes away, the highest first
+            while ((candidates & (candidates - 1)) && claimRequest()) {
+                const int highest = 31 - __builtin_clz(candidates);
+                Grid task = board;
+                task[cell] = (uint8_t) (1 + highest);
+                push(w, task);
+                candidates &= (uint16_t) ~(1u << highest);
+            }
+            solver.putNumber(board, cell, 1 + __builtin_ctz(candidates));
+            explore(w, board);
+            solver.undoTo(board, mark);
+        }
+    }
+};
+
+#endif //SOLUTIONENUMERATOR_H
@@ -0,0 +1,101 @@
+//
+// Per-solve statistics, and the compile-time policies that decide whether a solver collects them.
+//
+
+#ifndef SOLVESTATS_H
+#define SOLVESTATS_H
+
+#include <algorithm>
+#include <array>
+#include <ostream>
+
+// propagation rules a solver can report on. only the heuristics solver has rules so far.
+enum SolveRule { NAKED_SINGLE, HIDDEN_SINGLE, LOCKED_CANDIDATES, NAKED_TUPLE, HIDDEN_TUPLE, RULE_COUNT };
+
+inline const char* ruleName(const SolveRule &rule) {
+    static const char* names[RULE_COUNT] = {"naked single", "hidden single", "locked candidates", "naked tuple", "hidden tuple"};
+    return names[rule];
+}
+
+// what one solve did. counters a solver has no notion of (e.g. rules for DLX) stay 0.
+struct SolveStats {
+    long long nodes = 0;              // search nodes visited
+    long long guesses = 0;            // numbers placed by guessing, not deduced by a rule
+    long long backtracks = 0;         // guesses taken back
+    long long propagationRounds = 0;  // passes over the rules
+    long long guessPoints = 0;        // cells picked to guess on, each a lookup that used to scan all the cells
+    long long maxDepth = 0;           // deepest guess nesting reached
+    std::array<long long, RULE_COUNT> ruleHits{};      // passes where the rule changed something
+    std::array<long long, RULE_COUNT> eliminations{};  // candidates the rule removed (a placed cell losing its own not counted)
+
+    // adds up the counters of another solve, for corpus totals. maxDepth is the max of both.
+    SolveStats& operator+=(const SolveStats &o) {
+        nodes += o.nodes;
+        guesses += o.guesses;
+        backtracks += o.backtracks;
+        propagationRounds += o.propagationRounds;
+        guessPoints += o.guessPoints;
+        maxDepth = std::max(maxDepth, o.maxDepth);
+        for (int r = 0; r < RULE_COUNT; r++) {
+            ruleHits[r] += o.ruleHits[r];
+            eliminations[r] += o.eliminations[r];
+        }
+        return *this;
+    }
+
+    void print(std::ostream &out) const {
+        out << "nodes: " << nodes << ", guesses: " << guesses << ", backtracks: " << backtracks
+            << ", propagation rounds: " << propagationRounds << ", guess points: " << guessPoints
+            << ", max depth: " << maxDepth << std::endl;
+        for (int r = 0; r < RULE_COUNT; r++) {
+            if (ruleHits[r] == 0) continue;
+            out << "  " << ruleName((SolveRule) r) << ": " << ruleHits[r] << " hits, "
+                << eliminations[r] << " eliminations" << std::endl;
+        }
+    }
+};
+
+/**
+ * Stats policies. Solvers take one as a template parameter and call it at every event of the search:
+ *   - CollectStats fills a SolveStats.
+ *   - NoStats does nothing. Every call is an empty inline function, so a solver built with it has the same
+ *     hot path as one with no stats code at all.
+ * Work done only to compute an argument (e.g. counting changes) should be guarded with `if constexpr (Stats::enabled)`.
+ */
+struct CollectStats {
+    static constexpr bool enabled = true;
+    SolveStats stats;
+
+    void clear() { stats = SolveStats(); }
+    void node(const long long &depth) {
+        stats.nodes++;
+        stats.maxDepth = std::max(stats.maxDepth, depth);
+    }
+    void guess() { stats.guesses++; }
+    void backtrack() { stats.backtracks++; }
+    void round() { stats.propagationRounds++; }
+    void guessPoint() { stats.guessPoints++; }
+    void rule(const SolveRule &r, const long long &changed) {
+        stats.ruleHits[r]++;
+        stats.eliminations[r] += changed;
+    }
+    const SolveStats& get() const { return stats; }
+    // adds the counters of another solver, e.g. a parallel branch
+    void add(const CollectStats &o) { stats += o.stats; }
+};
+
+struct NoStats {
+    static constexpr bool enabled = false;
+
+    void clear() {}
+    void node(const long long &) {}
+    void guess() {}
+    void backtrack() {}
+    void round() {}
+    void guessPoint() {}
+    void rule(const SolveRule &, const long long &) {}
+    SolveStats get() const { return SolveStats(); }
+    void add(const NoStats &) {}
+};
+
+#endif //SOLVESTATS_H
@@ -0,0 +1,65 @@
+//
+// Every SudokuSolver the command line tools can pick by name.
+//
+
+#ifndef SOLVERREGISTRY_H
+#define SOLVERREGISTRY_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BacktrackingSolver.h"
+#include "DLXSolver.h"
+#include "HeuristicsBacktrackingSolver.h"
+#include "SizedSolver.h"
+#include "SudokuSolver.h"
+
+struct SolverInfo {
+    const char *name;
+    std::unique_ptr<SudokuSolver> (*create)();
+    // same solver built with CollectStats, so every solved board carries a SolveStats
+    std::unique_ptr<SudokuSolver> (*createWithStats)();
+};
+
+// add new solvers here to make them available to sudoku_bench (and anything else that picks solvers by name).
+inline const std::vector<SolverInfo>& registeredSolvers() {
+    static const std::vector<SolverInfo> solvers = {
+        {"backtracking",
+         []() -> std::unique_ptr<SudokuSolver> { return std::make_unique<BacktrackingSolver>(); },
+         []() -> std::unique_ptr<SudokuSolver> { return std::make_unique<BacktrackingSolverWithStats>(); }},
+        {"bitmask",
+         []() -> std::unique_ptr<SudokuSolver> { return std::make_unique<BitmaskSolver>(); },
+         []() -> std::unique_ptr<SudokuSolver> { return std::make_unique<BitmaskSolverWithStats>(); }},
+        {"heuristics",
+         []() -> std::unique_ptr<SudokuSolver> { return std::make_unique<HeuristicsBacktrackingSolver>(); },
+         []() -> std::unique_ptr<SudokuSolver> { return std::make_unique<HeuristicsBacktrackingSolverWithStats>(); }},
+        // speculative parallel search at the first guess point, one thread per core (latency of single hard puzzles).
+        // in solveBatch each worker only gets hardware_concurrency / workers of them (no oversubscription)
+        {"heuristics-parallel",
+         []() -> std::unique_ptr<SudokuSolver> {
+             auto solver = std::make_unique<HeuristicsBacktrackingSolver>();
+             solver->setParallel(0);
+             return solver;
+         },
+         []() -> std::unique_ptr<SudokuSolver> {
+             auto solver = std::make_unique<HeuristicsBacktrackingSolverWithStats>();
+             solver->setParallel(0);
+             return solver;
+         }},
+        {"dlx",
+         []() -> std::unique_ptr<SudokuSolver> { return std::make_unique<DLXSolver>(); },
+         []() -> std::unique_ptr<SudokuSolver> { return std::make_unique<DLXSolverWithStats>(); }},
+    };
+    return solvers;
+}
+
+// returns nullptr if there is no solver with that name.
+inline std::unique_ptr<SudokuSolver> makeSolver(const std::string &name, bool withStats = false) {
+    for (const SolverInfo &info : registeredSolvers()) {
+        if (name == info.name) return withStats ? info.createWithStats() : info.create();
+    }
+    return nullptr;
+}
+
+#endif //SOLVERREGISTRY_H
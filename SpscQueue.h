@@ -0,0 +1,82 @@
+//
+// Bounded lock-free single-producer/single-consumer queue, for handing frames between pipeline threads.
+//
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+/**
+ * ring buffer of CAPACITY items between exactly one producer thread and one consumer thread. push and pop are a
+ * couple of atomic loads/stores, nobody ever waits on a lock.
+ *
+ * made for live video: a stage that falls behind should work on the newest frame, not on a backlog. so the producer
+ * drops what it can't push (pushOrDrop) and the consumer skips to the newest item (popLatest). both count what they
+ * threw away in droppedCount().
+ *
+ * T must be default constructible and movable. popped slots are reset to T(), so e.g. a cv::Mat releases its
+ * buffer as soon as it leaves the queue.
+ */
+template <typename T, size_t CAPACITY>
+class SpscQueue {
+    static_assert(CAPACITY >= 1, "the queue must hold at least one item");
+    // one slot always stays empty, so head == tail means empty and tail + 1 == head means full
+    static constexpr size_t SLOTS = CAPACITY + 1;
+
+    std::array<T, SLOTS> slots;
+    alignas(64) std::atomic<size_t> head{0};  // next slot to pop, written by the consumer only
+    alignas(64) std::atomic<size_t> tail{0};  // next slot to push, written by the producer only
+    alignas(64) std::atomic<long long> dropped{0};
+
+public:
+    /**
+     * producer side.
+     * @return false if the queue is full (item is left untouched)
+     */
+    bool tryPush(T &&item) {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        const size_t next = (t + 1) % SLOTS;
+        if (next == head.load(std::memory_order_acquire)) return false;
+        slots[t] = std::move(item);
+        tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // producer side: pushes, or drops the item if the consumer is still busy with the full queue.
+    bool pushOrDrop(T &&item) {
+        if (tryPush(std::move(item))) return true;
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    /**
+     * consumer side.
+     * @return false if the queue is empty
+     */
+    bool tryPop(T &item) {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        item = std::move(slots[h]);
+        slots[h] = T();
+        head.store((h + 1) % SLOTS, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side: pops everything queued and keeps only the newest item. the older ones are stale, and dropped.
+    bool popLatest(T &item) {
+        if (!tryPop(item)) return false;
+        while (tryPop(item)) dropped.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // items thrown away by pushOrDrop and popLatest so far. safe to read from any thread.
+    long long droppedCount() const {
+        return dropped.load(std::memory_order_relaxed);
+    }
+};
+
+#endif //SPSCQUEUE_H
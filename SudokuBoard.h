@@ -5,38 +5,85 @@
 #ifndef SUDOKUBOARD_H
 #define SUDOKUBOARD_H
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <string>
+#include <type_traits>
 #include <vector>
 
+#include "BoardShape.h"
+#include "SolveStats.h"
+
+// 81 cells of a board in row major order (cell = row*9 + col). 0 means empty, 1-9 are the numbers.
+// it is a plain 81 byte value, so copying a board is a single memcpy.
+using Grid = Board9::Grid;
+
+// non-owning view of a Grid. view[row] points to the 9 contiguous cells of that row, so view[row][col] is a cell.
+template <typename T>
+class BasicGridView {
+    T* cells;
+public:
+    explicit BasicGridView(T* cells) : cells(cells) {}
+    // a mutable view can be used where a read-only one is expected
+    template <typename U>
+    BasicGridView(const BasicGridView<U> &other) : cells(other.data()) {}
+    T* operator[](int row) const { return cells + row * 9; }
+    T& cell(int i) const { return cells[i]; }
+    T* data() const { return cells; }
+};
+using GridView = BasicGridView<uint8_t>;
+using ConstGridView = BasicGridView<const uint8_t>;
+
 class SudokuBoard {
 private:
-    std::vector<std::vector<char>> board;
-    std::vector<std::vector<char>> board_solved;
-    int steps;
+    Grid board;
+    Grid board_solved;
+    int steps;  // search nodes of the last solve, only filled by solvers that collect stats
+    SolveStats stats;
     double time_spent;
     bool solved;
     // if board is put in `solve()` and can't find a solution, has_board becomes false.
     bool has_board;
-    std::string algorithm_used;
+    // always a string literal, so SudokuBoard stays trivially copyable and a batch of boards is one contiguous block.
+    const char* algorithm_used;
 public:
+    explicit SudokuBoard(const Grid &board_in)
+        : board(board_in), board_solved(), steps(0), stats(), time_spent(0), solved(false), has_board(true), algorithm_used("none")
+    {}
     SudokuBoard(std::vector<std::vector<char>> &&board_in)
-        : board(std::move(board_in)), steps(0), solved(false), time_spent(0), algorithm_used("none"), has_board(true)
+        : SudokuBoard(toGrid(board_in))
     {}
     SudokuBoard()
-        : board(), steps(0), solved(false), time_spent(0), algorithm_used("none"), has_board(false) {
-        board.resize(9, std::vector<char>(9, '.'));
-    }
+        : board(), board_solved(), steps(0), stats(), time_spent(0), solved(false), has_board(false), algorithm_used("none")
+    {}
 
     // this gets board that can be modified directly.
-    std::vector<std::vector<char>>& getOriginalBoard() {
+    Grid& getOriginalGrid() {
+        return board;
+    }
+    const Grid& getOriginalGrid() const {
         return board;
     }
-    const std::vector<std::vector<char>>& getSolvedBoard() const {
+    const Grid& getSolvedGrid() const {
         return board_solved;
     }
+    GridView originalView() {
+        return GridView(board.data());
+    }
+    ConstGridView originalView() const {
+        return ConstGridView(board.data());
+    }
+    ConstGridView solvedView() const {
+        return ConstGridView(board_solved.data());
+    }
     int getSteps() const {
         return steps;
     }
+    const SolveStats& getStats() const {
+        return stats;
+    }
     bool getSolvedStatus() const {
         return solved;
     }
@@ -50,35 +97,105 @@ public:
         return algorithm_used;
     }
 
-
-    // set board with move semantics
-    void setOriginalBoard(std::vector<std::vector<char>>&& board_in) {
-        board = std::move(board_in);
+    void setOriginalGrid(const Grid& board_in) {
+        board = board_in;
     }
-    void setSolvedBoard(std::vector<std::vector<char>>&& board_in) {
-        board_solved = std::move(board_in);
+    // sets the solution and marks the board as solved
+    void setSolvedGrid(const Grid& board_in) {
+        board_solved = board_in;
+        solved = true;
     }
     void setElapsedTime(double d) {
         time_spent = d;
     }
-    void setAlgorithmUsed(std::string s) {
+    // `s` must be a string literal (or outlive the board).
+    void setAlgorithmUsed(const char* s) {
         algorithm_used = s;
     }
+    // attaches the statistics of the solve, and sets steps to the number of search nodes.
+    void setStats(const SolveStats& s) {
+        stats = s;
+        steps = (int) s.nodes;
+    }
     void setHasBoard(bool b) {
         has_board = b;
     }
     // reverts everything as if it was not solved.
     void resetAll() {
-        board = std::vector<std::vector<char>>();
+        board.fill(0);
+        board_solved.fill(0);
         steps = 0;
+        stats = SolveStats();
         solved = false;
         time_spent = 0;
     }
 
-    // prints a board in formatted way
-    static void printBoard(const std::vector<std::vector<char>> &board) {
-        if (board.empty()) return;
+    // ---- compatibility layer for code written against the old std::vector<std::vector<char>> boards ('.' is empty) ----
 
+    // returns a copy of the board. Use getOriginalGrid() to modify it directly.
+    std::vector<std::vector<char>> getOriginalBoard() const {
+        return toNested(board);
+    }
+    // returns an empty vector if the board is not solved.
+    std::vector<std::vector<char>> getSolvedBoard() const {
+        if (!solved) return {};
+        return toNested(board_solved);
+    }
+    void setOriginalBoard(std::vector<std::vector<char>>&& board_in) {
+        board = toGrid(board_in);
+    }
+    void setSolvedBoard(std::vector<std::vector<char>>&& board_in) {
+        setSolvedGrid(toGrid(board_in));
+    }
+
+    static Grid toGrid(const std::vector<std::vector<char>> &nested) {
+        Grid grid{};
+        for (int i = 0; i < 9 && i < (int) nested.size(); i++) {
+            for (int j = 0; j < 9 && j < (int) nested[i].size(); j++) {
+                char c = nested[i][j];
+                grid[i*9+j] = (c >= '1' && c <= '9') ? c - '0' : 0;
+            }
+        }
+        return grid;
+    }
+    static std::vector<std::vector<char>> toNested(const Grid &grid) {
+        std::vector<std::vector<char>> nested(9, std::vector<char>(9, '.'));
+        for (int i = 0; i < 81; i++) {
+            if (grid[i] != 0) nested[i/9][i%9] = '0' + grid[i];
+        }
+        return nested;
+    }
+
+    /**
+     * parses the usual one line format: 81 characters in row major order, '1'-'9' for numbers and '.' or '0' for
+     * empty cells. anything after the 81st character is ignored.
+     * @return false if the line is too short or has some other character in the first 81.
+     */
+    static bool fromString(const char *s, size_t len, Grid &out) {
+        if (len < 81) return false;
+        for (int i = 0; i < 81; i++) {
+            char c = s[i];
+            if (c >= '1' && c <= '9') out[i] = c - '0';
+            else if (c == '.' || c == '0') out[i] = 0;
+            else return false;
+        }
+        return true;
+    }
+    static bool fromString(const std::string &s, Grid &out) {
+        return fromString(s.data(), s.size(), out);
+    }
+    // writes the board in the one line format (81 characters, '.' for empty). `out` must have room for 81 chars.
+    static void toString(const Grid &grid, char *out) {
+        for (int i = 0; i < 81; i++) out[i] = grid[i] == 0 ? '.' : '0' + grid[i];
+    }
+
+    // true if `solution` is a full valid board that keeps every clue of `puzzle`.
+    static bool isValidSolution(const Grid &puzzle, const Grid &solution) {
+        return Board9::isValidSolution(puzzle, solution);
+    }
+
+    // prints a board in formatted way
+    static void printBoard(const Grid &board) {
         using namespace std;
         for (int i = 0; i < 9; i++) {
             if (i % 3 == 0) {
@@ -88,10 +205,10 @@ public:
                 if (j % 3 == 0) {
                     cout << "| ";
                 }
-                if (board[i][j] == '.')
+                if (board[i*9+j] == 0)
                     cout << "  ";
                 else
-                    cout << board[i][j] << ' ';
+                    cout << (char) ('0' + board[i*9+j]) << ' ';
                 if (j == 8) {
                     cout << "|";
                 }
@@ -100,20 +217,32 @@ public:
         }
         cout << "+-------+-------+-------+" << endl;
     }
+    static void printBoard(const std::vector<std::vector<char>> &board) {
+        if (board.empty()) return;
+        printBoard(toGrid(board));
+    }
     // prints the time spent to solve
     void printTime() const {
-        if (algorithm_used == "none")
+        if (getAlgorithmUsed() == "none")
             std::cout << "Board unsolved yet." << std::endl;
         else
             std::cout << "Time Spent: " << time_spent << " seconds" << std::endl;
     }
+    // prints what the solver did. all zero unless it was solved by a solver that collects stats (e.g. DLXSolverWithStats)
+    void printStats() const {
+        stats.print(std::cout);
+    }
     // prints which algorithm was used in solving the board
     void printAlgorithmUsed() const {
-        if (algorithm_used == "none")
+        if (getAlgorithmUsed() == "none")
             std::cout << "Board unsolved yet." << std::endl;
         else
             std::cout << "Algorithm used: " << algorithm_used << std::endl;
     }
 };
 
+// boards solved together. SudokuBoard holds no pointers to heap memory, so the whole batch sits in one block.
+using SudokuBoardBatch = std::vector<SudokuBoard>;
+static_assert(std::is_trivially_copyable<SudokuBoard>::value, "SudokuBoard should be copyable with memcpy");
+
 #endif //SUDOKUBOARD_H
@@ -6,15 +6,40 @@
 #define SUDOKUSOLVER_H
 
 #include "SudokuBoard.h"
+#include "Timer.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <thread>
 #include <vector>
 
+// aggregate result of SudokuSolver::solveBatch
+struct BatchStats {
+    size_t boards = 0;
+    size_t solved = 0;
+    size_t failed = 0;
+    unsigned threads = 0;
+    double seconds = 0;  // wall clock time of the whole batch
+
+    double puzzlesPerSecond() const {
+        return seconds > 0 ? boards / seconds : 0;
+    }
+    void printThroughput() const {
+        std::cout << boards << " boards (" << solved << " solved, " << failed << " failed) on " << threads
+                  << " threads in " << seconds << " seconds: " << puzzlesPerSecond() << " puzzles/sec" << std::endl;
+    }
+};
+
+/**
+ * every solver is a template on a stats policy (see SolveStats.h), with two aliases: `XSolver` collects nothing and
+ * `XSolverWithStats` attaches a SolveStats to every board it solves. the choice is made at compile time so the
+ * plain solvers pay nothing for it.
+ */
 class SudokuSolver {
-protected:
-    bool iterationCount;
 public:
-    SudokuSolver()
-        : iterationCount(false) {
-    }
+    SudokuSolver() = default;
     virtual ~SudokuSolver() = default;
 
     /**
@@ -30,8 +55,90 @@ public:
      */
     virtual void resourceClear() = 0;
 
-    void enableIterationCount() {iterationCount = true;}
-    void disableIterationCount() {iterationCount = false;}
+    /**
+     * counts the solutions of the board, stopping the search as soon as `limit` of them are found.
+     * with the default limit this tells apart "no solution" (0), "unique" (1) and "2 or more" (2).
+     * pass a bigger limit (up to LLONG_MAX) to count every solution.
+     * the board is not modified.
+     * @return min(number of solutions, limit)
+     */
+    virtual long long countSolutions(const SudokuBoard &, long long limit = 2) = 0;
+
+    // true if the board has exactly one solution, i.e. it is a proper sudoku.
+    bool hasUniqueSolution(const SudokuBoard &sb) {
+        return countSolutions(sb, 2) == 1;
+    }
+
+    /**
+     * returns a new solver of the same kind and configuration, with its own state.
+     * solvers keep mutable state while solving, so every thread needs its own instance.
+     */
+    virtual std::unique_ptr<SudokuSolver> clone() const = 0;
+
+    /**
+     * a clone() for one of `workers` threads of solveBatch. the batch already keeps every core busy, so a solver
+     * that starts threads of its own inside a solve overrides this to use only its share of the cores.
+     */
+    virtual std::unique_ptr<SudokuSolver> cloneForBatch(const unsigned &) const {
+        return clone();
+    }
+
+    /**
+     * solves `count` contiguous boards on `threads` worker threads (0 = one per core), each with its own solver.
+     * the calling thread works too: with one thread it uses this solver, with more every thread (this one included)
+     * gets a cloneForBatch(). Boards are handed out in chunks that shrink as the batch drains (guided scheduling):
+     * early chunks are big to keep the shared counter cold, and the last ones are single
+     * boards so a few very hard puzzles at the end don't leave the other cores idle.
+     * every board is filled exactly as solve() would fill it.
+     * @return totals and wall clock throughput of the batch
+     */
+    BatchStats solveBatch(SudokuBoard *boards, size_t count, unsigned threads = 0) {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        threads = (unsigned) std::max<size_t>(1, std::min<size_t>(threads, count));
+
+        Timer t;
+        std::atomic<size_t> next(0);
+        std::vector<size_t> solvedPerThread(threads, 0);
+
+        auto work = [&](SudokuSolver &solver, size_t &solved) {
+            while (true) {
+                // claim [begin, begin + chunk)
+                size_t begin = next.load(std::memory_order_relaxed), chunk;
+                do {
+                    if (begin >= count) return;
+                    chunk = std::max<size_t>(1, (count - begin) / (4 * threads));
+                } while (!next.compare_exchange_weak(begin, begin + chunk, std::memory_order_relaxed));
+
+                for (size_t i = begin; i < begin + chunk; i++) {
+                    solver.solve(boards[i]);
+                    if (boards[i].hasBoard()) solved++;
+                }
+            }
+        };
+
+        std::vector<std::unique_ptr<SudokuSolver>> solvers;
+        if (threads > 1) {
+            for (unsigned i = 0; i < threads; i++) solvers.push_back(cloneForBatch(threads));
+        }
+        std::vector<std::thread> workers;
+        for (unsigned i = 1; i < threads; i++) {
+            workers.emplace_back(work, std::ref(*solvers[i]), std::ref(solvedPerThread[i]));
+        }
+        work(threads > 1 ? *solvers[0] : *this, solvedPerThread[0]);
+        for (auto &w : workers) w.join();
+
+        BatchStats stats;
+        stats.boards = count;
+        for (size_t s : solvedPerThread) stats.solved += s;
+        stats.failed = count - stats.solved;
+        stats.threads = threads;
+        stats.seconds = t.end();
+        return stats;
+    }
+
+    BatchStats solveBatch(SudokuBoardBatch &boards, unsigned threads = 0) {
+        return solveBatch(boards.data(), boards.size(), threads);
+    }
 
 };
 
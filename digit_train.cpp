@@ -0,0 +1,337 @@
+// Trains the built-in DigitClassifier and writes its weights (DigitWeights.h).
+//
+// There is no labeled set of camera cells in the repo, so the training set is synthetic: each digit is a few strokes
+// of a plain printed font, rendered into cell-sized images the way img_preprocess leaves them (white ink on black),
+// with random size, position, aspect, slant, rotation, stroke width and speckle noise. A softmax regression is fit on
+// the extract() features, quantized to int8, and then checked through the real classifier on a held out set. It also
+// times a whole board (81 cells) with every kernel, and checks the SIMD scores against the scalar ones.
+//
+// usage: digit_train [-o DigitWeights.h] [-n samples per digit] [-e epochs]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "DigitClassifier.h"
+#include "Timer.h"
+
+using namespace std;
+
+struct Point {
+    float x, y;
+};
+using Stroke = vector<Point>;
+using Glyph = vector<Stroke>;
+
+// ellipse arc in the unit glyph box (y down, so 270 degrees is the top), from a0 to a1 degrees in either direction
+static Stroke arc(float cx, float cy, float rx, float ry, float a0, float a1) {
+    Stroke s;
+    const int steps = max(4, (int) (fabs(a1 - a0) / 12));
+    for (int i = 0; i <= steps; i++) {
+        float a = (a0 + (a1 - a0) * i / steps) * (float) M_PI / 180;
+        s.push_back({cx + rx * cos(a), cy + ry * sin(a)});
+    }
+    return s;
+}
+
+static Stroke join(Stroke a, const Stroke &b) {
+    a.insert(a.end(), b.begin(), b.end());
+    return a;
+}
+
+// a few shapes per digit, x and y in 0..1
+static vector<vector<Glyph>> glyphs() {
+    vector<vector<Glyph>> g(9);
+    g[0] = {
+        {{{0.55f, 0}, {0.55f, 1}}, {{0.55f, 0}, {0.2f, 0.25f}}},
+        {{{0.55f, 0}, {0.55f, 1}}, {{0.55f, 0}, {0.2f, 0.25f}}, {{0.25f, 1}, {0.85f, 1}}},
+        {{{0.6f, 0}, {0.6f, 1}}, {{0.6f, 0}, {0.3f, 0.15f}}},
+    };
+    g[1] = {
+        {join(arc(0.5f, 0.27f, 0.4f, 0.27f, 190, 400), {{0.05f, 1}, {0.95f, 1}})},
+        {join(arc(0.5f, 0.3f, 0.42f, 0.3f, 200, 360), {{0.92f, 0.3f}, {0.05f, 1}, {0.95f, 1}})},
+    };
+    g[2] = {
+        {arc(0.48f, 0.25f, 0.38f, 0.25f, 200, 450), arc(0.5f, 0.73f, 0.42f, 0.27f, 270, 520)},
+        {{{0.1f, 0}, {0.85f, 0}, {0.45f, 0.42f}}, arc(0.5f, 0.7f, 0.42f, 0.3f, 240, 520)},
+    };
+    g[3] = {
+        {{{0.7f, 1}, {0.7f, 0}, {0.05f, 0.68f}, {0.95f, 0.68f}}},
+        {{{0.45f, 0}, {0.05f, 0.68f}, {0.95f, 0.68f}}, {{0.7f, 0.35f}, {0.7f, 1}}},
+    };
+    g[4] = {
+        {join({{0.85f, 0}, {0.22f, 0}}, arc(0.5f, 0.68f, 0.4f, 0.32f, 215, 520))},
+        {join({{0.85f, 0}, {0.2f, 0}, {0.15f, 0.48f}}, arc(0.48f, 0.68f, 0.4f, 0.32f, 210, 510))},
+    };
+    g[5] = {
+        {arc(0.52f, 0.5f, 0.42f, 0.5f, 300, 160), arc(0.52f, 0.7f, 0.4f, 0.3f, 0, 360)},
+        {{{0.7f, 0}, {0.15f, 0.65f}}, arc(0.52f, 0.7f, 0.4f, 0.3f, 0, 360)},
+    };
+    g[6] = {
+        {{{0.05f, 0}, {0.95f, 0}, {0.35f, 1}}},
+        {{{0.05f, 0.1f}, {0.05f, 0}, {0.95f, 0}, {0.45f, 1}}},
+    };
+    g[7] = {
+        {arc(0.5f, 0.26f, 0.33f, 0.26f, 0, 360), arc(0.5f, 0.73f, 0.4f, 0.27f, 0, 360)},
+        {arc(0.5f, 0.27f, 0.38f, 0.27f, 0, 360), arc(0.5f, 0.73f, 0.42f, 0.27f, 0, 360)},
+    };
+    g[8] = {
+        {arc(0.48f, 0.3f, 0.4f, 0.3f, 0, 360), arc(0.48f, 0.5f, 0.42f, 0.5f, 120, -20)},
+        {arc(0.48f, 0.3f, 0.4f, 0.3f, 0, 360), {{0.88f, 0.3f}, {0.3f, 1}}},
+    };
+    return g;
+}
+
+static float segmentDistance(Point p, Point a, Point b) {
+    float dx = b.x - a.x, dy = b.y - a.y;
+    float len = dx * dx + dy * dy;
+    float t = len > 0 ? ((p.x - a.x) * dx + (p.y - a.y) * dy) / len : 0;
+    t = max(0.0f, min(1.0f, t));
+    float ex = a.x + t * dx - p.x, ey = a.y + t * dy - p.y;
+    return sqrt(ex * ex + ey * ey);
+}
+
+// one random cell image of `glyph`, size x size pixels, ink 255
+static vector<uint8_t> render(const Glyph &glyph, int size, mt19937 &rng) {
+    uniform_real_distribution<float> u(0, 1);
+    auto range = [&](float lo, float hi) { return lo + (hi - lo) * u(rng); };
+
+    const float height = size * range(0.45f, 0.8f);
+    const float width = height * range(0.5f, 0.75f);
+    const float thickness = max(1.5f, height * range(0.07f, 0.17f));
+    const float slant = range(-0.15f, 0.2f), angle = range(-0.1f, 0.1f);
+    const float cx = size / 2.0f + range(-0.12f, 0.12f) * size, cy = size / 2.0f + range(-0.1f, 0.1f) * size;
+
+    // glyph box -> pixels: scale, slant, rotate around the center, move
+    vector<Stroke> strokes;
+    for (const Stroke &s : glyph) {
+        Stroke t;
+        for (Point p : s) {
+            float x = (p.x - 0.5f) * width, y = (p.y - 0.5f) * height;
+            x -= slant * y;
+            t.push_back({cx + x * cos(angle) - y * sin(angle), cy + x * sin(angle) + y * cos(angle)});
+        }
+        strokes.push_back(t);
+    }
+
+    vector<uint8_t> img(size * size, 0);
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            Point p{x + 0.5f, y + 0.5f};
+            for (const Stroke &s : strokes) {
+                for (size_t i = 0; i + 1 < s.size(); i++) {
+                    if (segmentDistance(p, s[i], s[i + 1]) <= thickness / 2) img[y * size + x] = 255;
+                }
+            }
+        }
+    }
+    // speckles the median blur didn't get, and pixels eaten by the threshold
+    const float flip = range(0, 0.004f);
+    for (uint8_t &v : img) {
+        if (u(rng) < (v ? flip * 4 : flip)) v ^= 255;
+    }
+    return img;
+}
+
+struct Dataset {
+    vector<uint8_t> features;  // n * FEATURES
+    vector<bool> ink;
+    vector<int> labels;        // 0..8 for digits 1..9
+};
+
+static Dataset makeDataset(int perDigit, uint32_t seed) {
+    const vector<vector<Glyph>> g = glyphs();
+    mt19937 rng(seed);
+    Dataset d;
+    d.features.resize((size_t) perDigit * 9 * DigitClassifier::FEATURES);
+    for (int i = 0; i < perDigit * 9; i++) {
+        const int digit = i % 9;
+        const int size = 30 + rng() % 31;
+        const Glyph &glyph = g[digit][rng() % g[digit].size()];
+        vector<uint8_t> img = render(glyph, size, rng);
+        d.ink.push_back(DigitClassifier::extract(img.data(), size, size, size,
+                                                 d.features.data() + (size_t) i * DigitClassifier::FEATURES));
+        d.labels.push_back(digit);
+    }
+    return d;
+}
+
+// softmax regression on features / 127, plain SGD with a little weight decay
+static void train(const Dataset &d, int epochs, vector<float> &w, vector<float> &b) {
+    const int F = DigitClassifier::FEATURES, C = DigitClassifier::CLASSES;
+    const int n = (int) d.labels.size();
+    w.assign(C * F, 0), b.assign(C, 0);
+    vector<int> order(n);
+    for (int i = 0; i < n; i++) order[i] = i;
+    mt19937 rng(7);
+    for (int e = 0; e < epochs; e++) {
+        shuffle(order.begin(), order.end(), rng);
+        const float rate = 0.05f / (1 + e * 0.3f);
+        double loss = 0;
+        for (int i : order) {
+            const uint8_t *f = d.features.data() + (size_t) i * F;
+            float z[9], zmax = -1e30f;
+            for (int c = 0; c < C; c++) {
+                float s = b[c];
+                for (int k = 0; k < F; k++) s += w[c * F + k] * f[k] * (1 / 127.0f);
+                z[c] = s, zmax = max(zmax, s);
+            }
+            float total = 0;
+            for (int c = 0; c < C; c++) total += (z[c] = exp(z[c] - zmax));
+            loss -= log(z[d.labels[i]] / total + 1e-12);
+            for (int c = 0; c < C; c++) {
+                const float g = z[c] / total - (c == d.labels[i]);
+                for (int k = 0; k < F; k++) w[c * F + k] -= rate * (g * f[k] * (1 / 127.0f) + 1e-5f * w[c * F + k]);
+                b[c] -= rate * g;
+            }
+        }
+        printf("epoch %2d  loss %.4f\n", e + 1, loss / n);
+    }
+}
+
+struct Quantized {
+    alignas(32) int8_t weights[9][256];
+    int32_t bias[9];
+    float scale;
+
+    DigitClassifier::Model model() const {
+        return {weights, bias, scale};
+    }
+};
+
+static Quantized quantize(const vector<float> &w, const vector<float> &b) {
+    const int F = DigitClassifier::FEATURES, C = DigitClassifier::CLASSES;
+    float maxAbs = 1e-6f;
+    for (float v : w) maxAbs = max(maxAbs, fabs(v));
+    // float logit = sum(w * f / 127) + b = (maxAbs / 127 / 127) * sum(q * f) + b
+    Quantized q{};
+    const float step = maxAbs / 127;
+    q.scale = step / 127;
+    for (int c = 0; c < C; c++) {
+        for (int k = 0; k < F; k++) q.weights[c][k] = (int8_t) lround(w[c * F + k] / step);
+        q.bias[c] = (int32_t) lround(b[c] / q.scale);
+    }
+    return q;
+}
+
+static void evaluate(const char *name, const DigitClassifier &classifier, const Dataset &d, float minConfidence) {
+    const int n = (int) d.labels.size();
+    vector<DigitClassifier::Result> out(n);
+    unique_ptr<bool[]> ink(new bool[n]);
+    for (int i = 0; i < n; i++) ink[i] = d.ink[i];
+    classifier.classify(d.features.data(), ink.get(), n, out.data());
+    int correct = 0, confident = 0, confidentWrong = 0;
+    for (int i = 0; i < n; i++) {
+        bool right = out[i].digit == d.labels[i] + 1;
+        correct += right;
+        if (out[i].confidence > minConfidence) confident++, confidentWrong += !right;
+    }
+    printf("%-9s accuracy %.2f%%   conf > %.0f: %.1f%% of cells, %d wrong (the rest would go to tesseract)\n",
+           name, 100.0 * correct / n, minConfidence, 100.0 * confident / n, confidentWrong);
+}
+
+static void writeHeader(const char *path, const Quantized &q) {
+    FILE *f = fopen(path, "w");
+    if (f == nullptr) {
+        perror(path);
+        exit(1);
+    }
+    fprintf(f, "//\n// Weights of the built-in DigitClassifier. Generated by digit_train, do not edit.\n//\n\n");
+    fprintf(f, "#ifndef DIGITWEIGHTS_H\n#define DIGITWEIGHTS_H\n\n#include <cstdint>\n\n");
+    fprintf(f, "// [digit - 1][16x16 feature, row major]\n");
+    fprintf(f, "alignas(32) inline const int8_t DIGIT_WEIGHTS[9][256] = {\n");
+    for (int c = 0; c < 9; c++) {
+        fprintf(f, "    {");
+        for (int k = 0; k < 256; k++) {
+            if (k % 16 == 0) fprintf(f, "\n        ");
+            fprintf(f, "%d,%s", q.weights[c][k], k % 16 == 15 ? "" : " ");
+        }
+        fprintf(f, "\n    },\n");
+    }
+    fprintf(f, "};\ninline const int32_t DIGIT_BIAS[9] = {");
+    for (int c = 0; c < 9; c++) fprintf(f, "%d%s", q.bias[c], c < 8 ? ", " : "");
+    fprintf(f, "};\ninline const float DIGIT_SCALE = %.9gf;\n\n#endif //DIGITWEIGHTS_H\n", q.scale);
+    fclose(f);
+}
+
+int main(int argc, char **argv) {
+    const char *output = nullptr;
+    int perDigit = 3000, epochs = 15;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-o") && i + 1 < argc) output = argv[++i];
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc) perDigit = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-e") && i + 1 < argc) epochs = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [-o DigitWeights.h] [-n samples per digit] [-e epochs]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    Dataset trainSet = makeDataset(perDigit, 1), testSet = makeDataset(500, 2);
+    vector<float> w, b;
+    train(trainSet, epochs, w, b);
+    Quantized q = quantize(w, b);
+
+    vector<const DigitClassifier::Kernel *> kernels = {&DigitClassifier::scalar()};
+#ifdef DIGIT_CLASSIFIER_X86
+    if (__builtin_cpu_supports("avx2")) kernels.push_back(&DigitClassifier::avx2());
+#endif
+
+    // every kernel has to give the exact scalar scores
+    const int n = (int) testSet.labels.size();
+    vector<int32_t> ref(n * 9), got(n * 9);
+    for (int i = 0; i < n; i += 64) {
+        DigitClassifier::scalar().scores(q.model(), testSet.features.data() + (size_t) i * 256, min(64, n - i), ref.data() + i * 9);
+    }
+    for (const DigitClassifier::Kernel *k : kernels) {
+        for (int i = 0; i < n; i += 64) {
+            k->scores(q.model(), testSet.features.data() + (size_t) i * 256, min(64, n - i), got.data() + i * 9);
+        }
+        if (ref != got) {
+            printf("kernel %s does not match the scalar kernel\n", k->name);
+            return 1;
+        }
+    }
+
+    printf("\nheld out set, %d cells\n", n);
+    evaluate("trained", DigitClassifier(q.model()), testSet, 95.0f);
+    evaluate("built-in", DigitClassifier(), testSet, 95.0f);
+
+    // one board: extract + classify 81 cells of a typical warped board (41x41 after the grid lines are cut off)
+    mt19937 rng(3);
+    const vector<vector<Glyph>> g = glyphs();
+    vector<vector<uint8_t>> board;
+    for (int i = 0; i < 81; i++) board.push_back(i % 3 ? vector<uint8_t>(41 * 41, 0) : render(g[i % 9][0], 41, rng));
+    alignas(32) static uint8_t features[81 * 256];
+    bool ink[81];
+    DigitClassifier::Result out[81];
+    const int reps = 2000;
+    printf("\n%-8s %14s %14s\n", "kernel", "extract us", "classify us");
+    for (const DigitClassifier::Kernel *k : kernels) {
+        DigitClassifier classifier(q.model(), *k);
+        Timer t1;
+        for (int r = 0; r < reps; r++) {
+            for (int i = 0; i < 81; i++) ink[i] = DigitClassifier::extract(board[i].data(), 41, 41, 41, features + i * 256);
+        }
+        double extractUs = t1.end() / reps * 1e6;
+        volatile float sink = 0;
+        Timer t2;
+        for (int r = 0; r < reps; r++) {
+            classifier.classify(features, ink, 81, out);
+            sink = sink + out[r % 81].confidence;
+        }
+        printf("%-8s %14.1f %14.1f\n", k->name, extractUs, t2.end() / reps * 1e6);
+    }
+
+    if (output != nullptr) {
+        writeHeader(output, q);
+        printf("\nwrote %s\n", output);
+    }
+    return 0;
+}
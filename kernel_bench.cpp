@@ -0,0 +1,189 @@
+// Microbenchmark for CandidateKernel: checks every SIMD kernel against the scalar one, then times each operation,
+// the solver's place/undo step (putNumber + undoTo, the innermost loop of the search) and a full
+// HeuristicsBacktrackingSolver solve with each kernel.
+//
+// usage: kernel_bench [iterations]
+//
+// what to expect (one x86 core with AVX2, 3 runs): the operations themselves are 4-7x faster with SIMD, but a whole
+// solve spends most of its time elsewhere (rules, trail, bookkeeping). Easy boards (#0, #1) solve 1.6-1.9x faster
+// than with the scalar kernel, the hard ones (#2-#4) only 1.05-1.4x. AVX2 is no faster than SSE2 for place/undo or
+// whole solves: eliminate touches 20 scattered lanes, and the wider scan alone doesn't show up.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "CandidateKernel.h"
+#include "HeuristicsBacktrackingSolver.h"
+#include "SudokuBoard.h"
+#include "Timer.h"
+
+using namespace std;
+
+// the QUICKTEST boards from main.cpp plus two well known hard ones
+static const char *PUZZLES[] = {
+    "53..7....6..195....98....6.8...6...34..8.3..17...2...6.6....28....419..5....8..79",
+    "1453.7...8......2..72.1.5..4....53...1..7...6..32...8..6.5....9..4....3......97..",
+    "..53.....8......2..7..1.5..........9.6.............1.31...4...2............6.7...",
+    "1....7.9..3..2...8..96..5....53..9...1..8...26....4...3......1..4......7..7...3..",
+    "8..........36......7..9.2...5...7.......457.....1...3...1....68..85...1..9....4..",
+};
+
+static Grid parse(const char *s) {
+    Grid g{};
+    for (int i = 0; i < 81; i++) g[i] = (s[i] >= '1' && s[i] <= '9') ? s[i] - '0' : 0;
+    return g;
+}
+
+// candidate masks right after the clues are placed, padded to CandidateKernel::LANES
+struct Masks {
+    alignas(32) uint16_t m[CandidateKernel::LANES];
+};
+
+static Masks initialMasks(const Grid &g) {
+    uint16_t row[9] = {}, col[9] = {}, grid[9] = {};
+    for (int i = 0; i < 81; i++) {
+        if (g[i] == 0) continue;
+        uint16_t bit = 1 << (g[i] - 1);
+        row[i/9] |= bit, col[i%9] |= bit, grid[(i/27)*3 + (i%9)/3] |= bit;
+    }
+    Masks ms{};
+    for (int i = 0; i < 81; i++) {
+        if (g[i] == 0) ms.m[i] = 0x1FF & ~(row[i/9] | col[i%9] | grid[(i/27)*3 + (i%9)/3]);
+    }
+    return ms;
+}
+
+static bool sameSet(const CellSet &a, const CellSet &b) {
+    return a.words == b.words;
+}
+
+// returns false if `k` disagrees with the scalar kernel on any state
+static bool verify(const CandidateKernel &k, const vector<Masks> &states) {
+    const CandidateKernel &ref = CandidateKernel::scalar();
+    for (const Masks &s : states) {
+        CandidateKernel::Scan a = k.scan(s.m), b = ref.scan(s.m);
+        if (!sameSet(a.singles, b.singles) || !sameSet(a.zeros, b.zeros)) return false;
+
+        uint16_t ua[27], ub[27];
+        k.unitUnions(s.m, ua);
+        ref.unitUnions(s.m, ub);
+        if (memcmp(ua, ub, sizeof(ua)) != 0) return false;
+
+        for (int cell = 0; cell < 81; cell++) {
+            for (int n = 0; n < 9; n++) {
+                Masks x = s, y = s;
+                CellSet ca = k.eliminate(x.m, cell, 1 << n), cb = ref.eliminate(y.m, cell, 1 << n);
+                if (!sameSet(ca, cb) || memcmp(x.m, y.m, sizeof(x.m)) != 0) return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    long iterations = argc > 1 ? atol(argv[1]) : 200000;
+
+    vector<const CandidateKernel *> kernels = {&CandidateKernel::scalar()};
+#ifdef CANDIDATE_KERNEL_X86
+    kernels.push_back(&CandidateKernel::sse2());
+    if (__builtin_cpu_supports("avx2")) kernels.push_back(&CandidateKernel::avx2());
+#endif
+    printf("best kernel on this CPU: %s\n\n", CandidateKernel::best().name);
+
+    // puzzle states plus pseudo random masks to cover odd bit patterns
+    vector<Masks> states;
+    for (const char *p : PUZZLES) states.push_back(initialMasks(parse(p)));
+    uint32_t seed = 12345;
+    for (int s = 0; s < 32; s++) {
+        Masks ms{};
+        for (int i = 0; i < 81; i++) {
+            seed = seed * 1664525 + 1013904223;
+            ms.m[i] = (seed >> 16) & 0x1FF;
+        }
+        states.push_back(ms);
+    }
+
+    for (const CandidateKernel *k : kernels) {
+        if (!verify(*k, states)) {
+            printf("kernel %s does not match the scalar kernel\n", k->name);
+            return 1;
+        }
+    }
+
+    printf("%-8s %12s %12s %12s %12s\n", "kernel", "scan ns", "elim ns", "unions ns", "place ns");
+    for (const CandidateKernel *k : kernels) {
+        volatile uint64_t sink = 0;
+        uint16_t unions[27];
+
+        Timer t1;
+        for (long i = 0; i < iterations; i++) {
+            CandidateKernel::Scan s = k->scan(states[i % states.size()].m);
+            sink = sink + s.singles.words[0];
+        }
+        double scanNs = t1.end() / iterations * 1e9;
+
+        Masks work = states[0];
+        Timer t2;
+        for (long i = 0; i < iterations; i++) {
+            // eliminating and putting the bit back keeps the state realistic without a copy per iteration
+            int cell = i % 81;
+            uint16_t bit = 1 << (i % 9);
+            CellSet changed = k->eliminate(work.m, cell, bit);
+            changed.forEach([&](int c) { work.m[c] |= bit; });
+            sink = sink + changed.words[0];
+        }
+        double elimNs = t2.end() / iterations * 1e9;
+
+        Timer t3;
+        for (long i = 0; i < iterations; i++) {
+            k->unitUnions(states[i % states.size()].m, unions);
+            sink = sink + unions[i % 27];
+        }
+        double unionNs = t3.end() / iterations * 1e9;
+
+        // put a candidate in an empty cell of a hard puzzle and take it back, over and over
+        HeuristicsBacktrackingSolver solver;
+        solver.setKernel(*k);
+        Grid board = parse(PUZZLES[2]);
+        solver.setBoard(board);
+        vector<int> empty;
+        for (int cell = 0; cell < 81; cell++) {
+            if (board[cell] == 0) empty.push_back(cell);
+        }
+        const int mark = solver.trailMark();
+        Timer t4;
+        for (long i = 0; i < iterations; i++) {
+            int cell = empty[i % empty.size()];
+            solver.putNumber(board, cell, 1 + __builtin_ctz(solver.getCandidates(cell)));
+            solver.undoTo(board, mark);
+        }
+        double placeNs = t4.end() / iterations * 1e9;
+
+        printf("%-8s %12.1f %12.1f %12.1f %12.1f\n", k->name, scanNs, elimNs, unionNs, placeNs);
+    }
+
+    // whole solves, same solver with each kernel
+    printf("\nHeuristicsBacktrackingSolver, microseconds per puzzle\n%-8s", "kernel");
+    for (size_t p = 0; p < sizeof(PUZZLES) / sizeof(PUZZLES[0]); p++) printf(" %10s", ("#" + to_string(p)).c_str());
+    printf("\n");
+    int solveReps = max(1L, iterations / 1000);
+    for (const CandidateKernel *k : kernels) {
+        HeuristicsBacktrackingSolver solver;
+        solver.setKernel(*k);
+        printf("%-8s", k->name);
+        for (const char *p : PUZZLES) {
+            double total = 0;
+            for (int r = 0; r < solveReps; r++) {
+                SudokuBoard sb(parse(p));
+                solver.solve(sb);
+                total += sb.getTime();
+            }
+            printf(" %10.2f", total / solveReps * 1e6);
+        }
+        printf("\n");
+    }
+    return 0;
+}
@@ -1,9 +1,15 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
 #include <string>
 #include <vector>
 #include <set>
 #include <map>
 #include <iostream>
 #include <thread>
+#include <atomic>
+#include <chrono>
+#include <mutex>
 
 #include <opencv2/opencv.hpp>
 #include <opencv2/imgcodecs.hpp>
@@ -12,12 +18,22 @@
 #include <tesseract/baseapi.h>
 
 #include "BacktrackingSolver.h"
+#include "BoardTracker.h"
+#include "DigitClassifier.h"
+#include "DLXSolver.h"
 #include "HeuristicsBacktrackingSolver.h"
+#include "LruCache.h"
+#include "OcrEnginePool.h"
+#include "Profiler.h"
+#include "SpscQueue.h"
 #include "SudokuSolver.h"
 #include "SudokuBoard.h"
 
 #define BOARD_WIDTH 495;
 #define BOARD_HEIGHT 495; // choose 495x495 because it divides wholly into 9
+#define BOARD_LOST_FRAMES 15 // frames without a board in sight before the solved one is forgotten
+#define SOLUTION_CACHE_SIZE 8 // solved boards (with their rendered solution) kept for when they come back
+#define OCR_MIN_CONFIDENCE 95.0f // a cell is read as a digit only above this confidence (0-100), by either recognizer
 
 // #define QUICKTEST 1;
 
@@ -63,21 +79,40 @@ int main() {
 
     SudokuBoard sb1(std::move(veryhard));
 
-    HeuristicsBacktrackingSolver solver_backtracking;
+    HeuristicsBacktrackingSolverWithStats solver_backtracking;
     SudokuSolver &solver = solver_backtracking;
 
     solver.solve(sb1);
 
     // print solved status
-    SudokuBoard::printBoard(sb1.getSolvedBoard());
+    SudokuBoard::printBoard(sb1.getSolvedGrid());
     sb1.printTime();
     sb1.printAlgorithmUsed();
+    sb1.printStats();
 
     return 0;
 }
 #endif
 
 #ifndef QUICKTEST
+// stage timings. every pipeline thread has its own profiler (Profiler is not thread safe), and publishes it with
+// reportProfile() every PROFILE_REPORT_SECONDS: printed to stdout, and drawn on the camera view.
+thread_local Profiler profiler;
+#define PROFILE_REPORT_SECONDS 5.0
+
+std::mutex profile_mutex;
+std::map<std::string, std::vector<std::string>> profile_lines; // last published breakdown of each thread
+
+// publishes the profile of the calling thread if its window is PROFILE_REPORT_SECONDS long. call it once per loop.
+void reportProfile(const std::string& thread_name) {
+    if (profiler.windowSeconds() < PROFILE_REPORT_SECONDS) return;
+    std::lock_guard<std::mutex> lock(profile_mutex);
+    std::cout << "[" << thread_name << " thread] ";
+    profiler.print(std::cout);
+    profile_lines[thread_name] = profiler.lines();
+    profiler.resetWindow();
+}
+
 // convers raw image to canny (just to look more cool)
 void to_canny(cv::Mat& in, cv::Mat& out) {
     cv::Mat grayed, blurred;
@@ -109,7 +144,31 @@ void img_preprocess(cv::Mat& in, cv::Mat& out) {
     cv::medianBlur(morph, out, 3);
 }
 
-// finds the coordinates of the (supposedly) sudoku board
+// orders the 4 corners of a quad clockwise on screen, starting at the top left one: top left, top right, bottom right,
+// bottom left. approxPolyDP starts wherever the contour starts, so its order alone says nothing.
+void orderCorners(std::vector<cv::Point>& quad) {
+    float cx = 0, cy = 0;
+    for (const cv::Point& p : quad) cx += p.x, cy += p.y;
+    cv::Point2f center(cx / quad.size(), cy / quad.size());
+    // y grows downwards, so growing angles go clockwise on screen
+    std::sort(quad.begin(), quad.end(), [&](const cv::Point& a, const cv::Point& b) {
+        return std::atan2(a.y - center.y, a.x - center.x) < std::atan2(b.y - center.y, b.x - center.x);
+    });
+    auto topLeft = std::min_element(quad.begin(), quad.end(), [](const cv::Point& a, const cv::Point& b) {
+        return a.x + a.y < b.x + b.y;
+    });
+    std::rotate(quad.begin(), topLeft, quad.end());
+}
+
+// the corners of a board that reads upright after turning the warped image quarterTurns * 90 degrees clockwise,
+// in the same top left, top right, bottom right, bottom left order
+std::vector<cv::Point> turnCorners(const std::vector<cv::Point>& coords, const int& quarterTurns) {
+    std::vector<cv::Point> turned(coords.size());
+    for (size_t k = 0; k < coords.size(); k++) turned[k] = coords[(k + 4 - quarterTurns) % 4];
+    return turned;
+}
+
+// finds the coordinates of the (supposedly) sudoku board, ordered by orderCorners
 std::vector<cv::Point> findBoardCoordinates(cv::Mat& in, cv::Mat& img_to_draw) {
     std::vector<std::vector<cv::Point>> contours;
     std::vector<cv::Vec4i> hierarchy;
@@ -149,6 +208,7 @@ std::vector<cv::Point> findBoardCoordinates(cv::Mat& in, cv::Mat& img_to_draw) {
 
         nextcontour:
     }
+    if (!maxContour.empty()) orderCorners(maxContour);
     // visualize the detected
     cv::polylines(img_to_draw, maxContour, true, cv::Scalar(0, 0, 255), 3);
     return maxContour;
@@ -160,7 +220,7 @@ void warpImage(const std::vector<cv::Point>& coords, const cv::Mat& img_src, cv:
     float h = BOARD_HEIGHT; // 495 cuz this is perfectly divided into 9.
     cv::Point2f src_points[4];
     copy(coords.begin(), coords.end(), src_points);
-    cv::Point2f dest_points[4] = {{w, 0}, {0, 0}, {0, h}, {w, h}}; // TODO: idk why but top right corner is at index 0 in src_points, so I had to
+    cv::Point2f dest_points[4] = {{0, 0}, {w, 0}, {w, h}, {0, h}}; // coords come from orderCorners
 
     cv::Mat transform_mat = cv::getPerspectiveTransform(src_points, dest_points);
     cv::warpPerspective(img_src, img_output, transform_mat, cv::Point(w, h));
@@ -218,22 +278,21 @@ double blackPixelPercentage(cv::Mat& gray) {
 
 // builds the square img of solution to the board (not warped yet)
 cv::Mat buildSolutionImage(SudokuBoard &sb) {
-    if (sb.getSolvedBoard().empty()) return cv::Mat();
+    if (!sb.getSolvedStatus()) return cv::Mat();
     int w = BOARD_WIDTH; int h = BOARD_HEIGHT;
     cv::Mat img_solution = cv::Mat::zeros(w, h, CV_8UC4);
-    const vector<vector<char>>& board_unsolved = sb.getOriginalBoard();
-    const vector<vector<char>>& board_solved = sb.getSolvedBoard();
+    ConstGridView board_unsolved = sb.originalView();
+    ConstGridView board_solved = sb.solvedView();
     int x, y;
     for (int i = 0; i < 9; i++) {
         for (int j = 0; j < 9; j++) {
-            if (board_unsolved[i][j] == '.') {
+            if (board_unsolved[i][j] == 0) {
                 x = w/9 * j + w/25, y = h/9 * i + h/12;
 
-                cv::putText(img_solution, to_string(board_solved[i][j] - '0'), cv::Point(x, y), cv::FONT_HERSHEY_SIMPLEX, 1.1, cv::Scalar(0, 255, 0), 2.5);
+                cv::putText(img_solution, to_string(board_solved[i][j]), cv::Point(x, y), cv::FONT_HERSHEY_SIMPLEX, 1.1, cv::Scalar(0, 255, 0), 2.5);
             }
         }
     }
-    cv::imshow("Solution Image", img_solution);
     return img_solution;
 }
 
@@ -246,11 +305,30 @@ void printMetrics(SudokuBoard& sb, cv::Mat& img_canvas) {
     cv::putText(img_canvas, "Time Spent: " + to_string(sb.getTime()) + " seconds", cv::Point(2 * w/5, h - h/16), cv::FONT_HERSHEY_SIMPLEX, 2, cv::Scalar(0, 255, 0), 3.5);
 }
 
+// draws the last published stage breakdown of every thread in the top left corner, then the `extra` lines
+void printProfile(cv::Mat& img_canvas, const std::vector<std::string>& extra) {
+    int h = img_canvas.rows;
+    int line_h = h / 40;
+    int y = line_h;
+    auto draw = [&](const std::string& line) {
+        cv::putText(img_canvas, line, cv::Point(10, y), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 255, 255), 1);
+        y += line_h;
+    };
+    {
+        std::lock_guard<std::mutex> lock(profile_mutex);
+        for (const auto& [thread_name, lines] : profile_lines) {
+            draw("[" + thread_name + "]");
+            for (const std::string& line : lines) draw(line);
+        }
+    }
+    for (const std::string& line : extra) draw(line);
+}
+
 // warp and overlay the solution image to the background
 void warpSolutionImage(const std::vector<cv::Point>& coords, cv::Mat &img_sol, cv::Mat& img_canvas) {
     float w = BOARD_WIDTH;
     float h = BOARD_HEIGHT;
-    cv::Point2f src_points[4] = {{w, 0}, {0, 0}, {0, h}, {w, h}};
+    cv::Point2f src_points[4] = {{0, 0}, {w, 0}, {w, h}, {0, h}}; // same order as coords (orderCorners)
     cv::Point2f dest_points[4];
     std::copy(coords.begin(), coords.end(), dest_points);
 
@@ -269,143 +347,399 @@ void warpSolutionImage(const std::vector<cv::Point>& coords, cv::Mat &img_sol, c
     img_warped.copyTo(img_canvas, mask);
 }
 
-bool parseSudokuBoard(SudokuBoard& sb, cv::Mat& img_sudoku) {
-    tesseract::TessBaseAPI tess;
-    if (tess.Init(NULL, "eng", tesseract::OEM_LSTM_ONLY)) {
-        std::cerr << "Could not initialize tesseract.\n";
-        return false;
+// the crop of board cell `cell` (row major, as warped), turned quarterTurns * 90 degrees clockwise.
+// the unturned crop points into img_sudoku, turned ones are fresh Mats.
+cv::Mat boardCell(const cv::Mat& img_sudoku, const int& cell, const int& quarterTurns) {
+    int cell_sz = img_sudoku.cols / 9;
+    int line_sz = cell_sz / 7; // we consider the line to be 1/7 of cell size
+    cv::Rect roi((cell % 9) * cell_sz + line_sz, (cell / 9) * cell_sz + line_sz, cell_sz - 2 * line_sz, cell_sz - 2 * line_sz);
+    cv::Mat img_cell = img_sudoku(roi);
+    if (quarterTurns == 0) return img_cell;
+    cv::Mat img_turned;
+    cv::rotate(img_cell, img_turned, quarterTurns - 1); // ROTATE_90_CLOCKWISE, ROTATE_180, ROTATE_90_COUNTERCLOCKWISE
+    return img_turned;
+}
+
+/**
+ * OCRs the warped board once, in the orientation it reads upright in.
+ * the built-in classifier reads every cell, the cells it isn't sure about go to the engine pool as one batch.
+ * the orientation is settled first, as cheap as possible:
+ *   - upright, if the classifier is sure about 3/4 of the cells as they are (the usual case, nothing else runs)
+ *   - else the turn in which the classifier is sure about the most cells (the other 3 turns are the same features,
+ *     turned, so this is one more classify call)
+ *   - if that is no clear winner either (a font the classifier doesn't know), tesseract reads the 4 inkiest cells in
+ *     every turn, and the turn with the most digits wins
+ * @param orientation out: quarter turns clockwise that make the warped board upright (see turnCorners)
+ */
+bool parseSudokuBoard(SudokuBoard& sb, int& orientation, cv::Mat& img_sudoku, const DigitClassifier& classifier, OcrEnginePool& ocr) {
+    constexpr int F = DigitClassifier::FEATURES;
+
+    // [r * 81 + i]: cell i of the board turned r times. only turn 0 is extracted, the others turn its features.
+    std::vector<uint8_t> features(4 * 81 * F);
+    bool hasInk[4 * 81] = {};
+    DigitClassifier::Result results[4 * 81];
+    int inked = 0;
+    {
+        ProfileScope scope(profiler, "classify cells");
+        for (int i = 0; i < 81; i++) {
+            cv::Mat img_cell = boardCell(img_sudoku, i, 0);
+            // if img_cell is almost 88% composed of black, just skip it, as it's not a character
+            if (blackPixelPercentage(img_cell) > 88.0)
+                continue;
+            hasInk[i] = DigitClassifier::extract(img_cell.data, img_cell.cols, img_cell.rows, img_cell.step, &features[i * F]);
+            inked += hasInk[i];
+        }
+        classifier.classify(features.data(), hasInk, 81, results);
     }
-    tess.SetPageSegMode(tesseract::PSM_SINGLE_CHAR);
+    if (inked <= 9) return false; // not enough to be a board, see the end
 
-    int width = img_sudoku.cols, height = img_sudoku.rows;
-    int cell_sz = width / 9;
-    int line_sz = cell_sz / 7; // we consider the line to be 1/7 of cell size
+    auto confident = [&](const int& k) { return hasInk[k] && results[k].confidence > OCR_MIN_CONFIDENCE; };
+    auto confidentCount = [&](const int& turn) {
+        int count = 0;
+        for (int i = 0; i < 81; i++) count += confident(turn * 81 + i);
+        return count;
+    };
 
-    auto &board = sb.getOriginalBoard();
-    // Rotate the matrix in every direction.
-    cv::Mat img_rotated = img_sudoku.clone();
-    unsigned int maxParseCnt = 0;
-
-    for (int rotateCode = -1; rotateCode < 3; rotateCode++) {
-        if (rotateCode != -1)
-            cv::rotate(img_sudoku, img_rotated, rotateCode);
-
-        unsigned int parsedCount = 0;
-        vector<vector<char>> tempBoard; tempBoard.resize(9, vector<char>(9, '.'));
-
-        for (int i = 0; i < 9; i++) {
-            for (int j = 0; j < 9; j++) {
-                cv::Rect roi(j * cell_sz + line_sz, i * cell_sz + line_sz, cell_sz - 2 * line_sz, cell_sz - 2 * line_sz);
-                cv::Mat img_cell = img_rotated(roi);
-
-                // if img_cell is almost 88% composed of black, just skip it, as it's not a character
-                if (blackPixelPercentage(img_cell) > 88.0)
-                    continue;
-
-                // Preprocess each cell for better OCR accuracy
-                cv::Mat img_cell_processed = img_cell; // extractDigit(img_cell);
-
-                // cv::imshow("row " + to_string(i) + " col: " + to_string(j), img_cell);
-
-                // Parse img_cell with tesseract
-                tess.SetImage(img_cell_processed.data, img_cell_processed.cols, img_cell_processed.rows, 1, img_cell_processed.step);
-                tess.Recognize(0);
-                tesseract::ResultIterator* ri = tess.GetIterator();
-                if (ri != nullptr) {
-                    do {
-                        const char* symbol = ri->GetUTF8Text(tesseract::RIL_SYMBOL);
-                        float conf = ri->Confidence(tesseract::RIL_SYMBOL);
-
-                        if (symbol != nullptr && std::isdigit(symbol[0]) && conf > 95.0) { // Only accept high confidence digits
-                            tempBoard[i][j] = symbol[0]; // Convert char to int
-                            parsedCount++;
-                        }
-
-                        delete[] symbol;
-                    } while (ri->Next(tesseract::RIL_SYMBOL));
-                    delete ri;
-                }
+    orientation = 0;
+    if (confidentCount(0) * 4 < inked * 3) {
+        ProfileScope scope(profiler, "orientation");
+        for (int turn = 1; turn < 4; turn++) {
+            for (int i = 0; i < 81; i++) {
+                int source = DigitClassifier::rotatedSource(i / 9, i % 9, 9, turn);
+                hasInk[turn * 81 + i] = hasInk[source];
+                if (hasInk[source]) DigitClassifier::rotate(&features[source * F], turn, &features[(turn * 81 + i) * F]);
             }
         }
+        classifier.classify(&features[81 * F], &hasInk[81], 3 * 81, &results[81]);
+
+        int votes[4], runnerUp = 0;
+        for (int turn = 0; turn < 4; turn++) {
+            votes[turn] = confidentCount(turn);
+            if (votes[turn] > votes[orientation]) orientation = turn;
+        }
+        for (int turn = 0; turn < 4; turn++) {
+            if (turn != orientation) runnerUp = std::max(runnerUp, votes[turn]);
+        }
+
+        if (votes[orientation] < 3 || votes[orientation] <= runnerUp) {
+            // the 4 cells with the most ink, in all 4 turns, as one batch
+            std::vector<int> inkiest;
+            for (int i = 0; i < 81; i++) {
+                if (hasInk[i]) inkiest.push_back(i);
+            }
+            auto ink = [&](const int& cell) { return std::accumulate(&features[cell * F], &features[(cell + 1) * F], 0); };
+            std::sort(inkiest.begin(), inkiest.end(), [&](const int& a, const int& b) { return ink(a) > ink(b); });
+            inkiest.resize(std::min<size_t>(4, inkiest.size()));
 
-        if (parsedCount > maxParseCnt) { // if this version of rotation could parse more things than the max so far, use this one
-            sb.setOriginalBoard(std::move(tempBoard));
-            maxParseCnt = parsedCount;
+            std::vector<cv::Mat> probe;
+            for (int turn = 0; turn < 4; turn++) {
+                for (int cell : inkiest) probe.push_back(boardCell(img_sudoku, cell, turn));
+            }
+            std::vector<uint8_t> probeDigits;
+            ocr.recognize(probe, probeDigits, OCR_MIN_CONFIDENCE);
+
+            int bestScore = -1;
+            for (int turn = 0; turn < 4; turn++) {
+                int reads = 0;
+                for (size_t c = 0; c < inkiest.size(); c++) reads += probeDigits[turn * inkiest.size() + c] != 0;
+                int score = reads * 100 + votes[turn]; // ties go to the classifier vote
+                if (score > bestScore) bestScore = score, orientation = turn;
+            }
         }
     }
 
-    tess.End();
-    if (maxParseCnt > 9) { // if we can parse more than 9 cells, we consider it as correct board parsing.
+    // the board in its orientation, read once: the classifier's digits where it's sure, tesseract for the rest
+    const int first = orientation * 81;
+    std::vector<cv::Mat> cells(81);
+    size_t fallbackCount = 0;
+    for (int i = 0; i < 81; i++) {
+        if (!hasInk[first + i] || confident(first + i)) continue;
+        cells[i] = boardCell(img_sudoku, DigitClassifier::rotatedSource(i / 9, i % 9, 9, orientation), orientation);
+        fallbackCount++;
+    }
+    std::vector<uint8_t> digits(81, 0);
+    if (fallbackCount > 0) {
+        ProfileScope scope(profiler, "ocr cells");
+        ocr.recognize(cells, digits, OCR_MIN_CONFIDENCE); // Only accept high confidence digits
+    }
+
+    Grid board{};
+    unsigned int parsedCount = 0;
+    for (int i = 0; i < 81; i++) {
+        board[i] = confident(first + i) ? results[first + i].digit : digits[i];
+        if (board[i] != 0) parsedCount++;
+    }
+    sb.setOriginalGrid(board);
+
+    if (parsedCount > 9) { // if we can parse more than 9 cells, we consider it as correct board parsing.
         sb.setHasBoard(true);
         return true;
     }
     return false;
 }
 
-int main() {
-    using namespace cv;
-    Mat img, img_processed;
+// what the pipeline threads hand each other. cv::Mat is reference counted, so these are cheap to move, but every
+// stage must write into fresh Mats, never into one it already pushed.
+struct Frame {
+    cv::Mat img;
+};
+struct Detection {
+    cv::Mat img_show;                // camera view to draw on (canny + red contour)
+    std::vector<cv::Point> coords;   // board corners, empty if no board in sight
+    cv::Mat img_sudoku;              // warped board, only while no board is solved yet
+    bool tracked = false;            // coords were tracked from the last frame, not found by the full detection
+};
+struct Solution {
     SudokuBoard sb;
-    HeuristicsBacktrackingSolver solver_backtracking; // change here whatever solver you want to use.
-    SudokuSolver &solver = solver_backtracking;
-    cv::Mat img_solution;
-
-    VideoCapture cap(0);
-    if (!cap.isOpened()) {
-        std::cerr << "Error: Could not open video capture device." << std::endl;
-        return -1;
-    }
+    cv::Mat img_solution;  // upright board
+    int orientation = 0;   // quarter turns clockwise from the warped board to img_solution (see turnCorners)
+};
+
+/**
+ * capture -> detection -> OCR + solve, and detection -> display, each pair connected by a small SPSC queue.
+ * a stage that is busy doesn't make the others wait: frames it can't take are dropped, and a stage that falls behind
+ * skips to the newest frame. so the camera view keeps moving at detection speed while OCR runs, and the display keeps
+ * drawing the last known solution on the newest board corners.
+ */
+struct Pipeline {
+    SpscQueue<Frame, 2> captured;      // capture -> detection
+    SpscQueue<Detection, 2> detected;  // detection -> display
+    SpscQueue<cv::Mat, 1> boards;      // detection -> ocr (warped boards to parse)
+    SpscQueue<Solution, 1> solutions;  // ocr -> display. never dropped: ocr holds one until the display takes it
+    std::atomic<bool> running{true};
+    std::atomic<bool> solved{false};   // the board in sight was parsed and solved, stop sending boards to OCR.
+                                       // detection clears it when the board is gone for BOARD_LOST_FRAMES frames.
+};
+
+// a stage with nothing to do waits this long before polling its queue again
+void idle() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
 
-    while (true) {
-        cap.read(img);
-        if (img.empty()) {
+void captureStage(Pipeline& p, cv::VideoCapture& cap) {
+    while (p.running) {
+        Frame frame; // a new Mat every time: the previous one may still be in use downstream
+        {
+            ProfileScope scope(profiler, "capture");
+            cap.read(frame.img);
+        }
+        if (frame.img.empty()) {
             std::cerr << "Error: Could not read frame from video capture device." << std::endl;
+            p.running = false;
             break;
         }
+        p.captured.pushOrDrop(std::move(frame));
+        reportProfile("capture");
+    }
+}
 
-        // make a screen to show (apply canny to look cool!)
-        Mat img_show;
-        to_canny(img, img_show);
-
-        // Process image and store in img_processed
-        img_preprocess(img, img_processed);
-
-        // Find coordinates and draw the red contour
-        std::vector<Point> coords = findBoardCoordinates(img_processed, img_show);
-
-        if (!sb.hasBoard()) { // if board was not parsed yet, (if board is parsed, sb.hasBoard changes to true)
+void detectionStage(Pipeline& p) {
+    Frame frame;
+    BoardTracker tracker;
+    int frames_without_board = 0;
+    while (p.running) {
+        if (!p.captured.popLatest(frame)) {
+            idle();
+            continue;
+        }
+        Detection d;
+        {
+            ProfileScope frame_scope(profiler, "detect");
+            cv::Mat img_processed;
+            // make a screen to show (apply canny to look cool!)
+            {
+                ProfileScope scope(profiler, "canny");
+                to_canny(frame.img, d.img_show);
+            }
+            // a locked board is followed from the last frame, the full detection only runs when that fails
+            cv::Mat img_gray; // a new Mat every frame: the tracker keeps the last one
+            cv::cvtColor(frame.img, img_gray, cv::COLOR_BGR2GRAY);
+            if (tracker.locked()) {
+                ProfileScope scope(profiler, "track board");
+                d.tracked = tracker.track(img_gray, d.coords);
+                if (d.tracked) cv::polylines(d.img_show, d.coords, true, cv::Scalar(0, 0, 255), 3);
+            }
+            if (!d.tracked) {
+                // Process image and store in img_processed
+                {
+                    ProfileScope scope(profiler, "preprocess");
+                    img_preprocess(frame.img, img_processed);
+                }
+                // Find coordinates and draw the red contour
+                {
+                    ProfileScope scope(profiler, "find board");
+                    d.coords = findBoardCoordinates(img_processed, d.img_show);
+                }
+                if (!d.coords.empty()) {
+                    ProfileScope scope(profiler, "lock board");
+                    tracker.lock(img_gray, d.coords);
+                }
+            }
+            // the solved board left: the next one is read again (a known puzzle is then found in the solution cache)
+            frames_without_board = d.coords.empty() ? frames_without_board + 1 : 0;
+            if (frames_without_board == BOARD_LOST_FRAMES) p.solved = false;
+
+            if (!p.solved && !d.coords.empty()) {
+                if (img_processed.empty()) {
+                    ProfileScope scope(profiler, "preprocess");
+                    img_preprocess(frame.img, img_processed);
+                }
+                {
+                    ProfileScope scope(profiler, "warp board");
+                    warpImage(d.coords, img_processed, d.img_sudoku);
+                }
+                // dropped if OCR is still busy with an earlier board
+                p.boards.pushOrDrop(d.img_sudoku.clone());
+            }
+        }
+        p.detected.pushOrDrop(std::move(d));
+        reportProfile("detection");
+    }
+}
 
-            Mat img_sudoku;
-            warpImage(coords, img_processed, img_sudoku);
-            imshow("Sudoku Board Warped", img_sudoku);
+void ocrStage(Pipeline& p, SudokuSolver& solver, const DigitClassifier& classifier, OcrEnginePool& ocr) {
+    cv::Mat img_sudoku;
+    // clue grid -> solved board and rendered solution. seeing a known puzzle again costs only its parse.
+    LruCache<Grid, Solution, Board9::Hash> cache(SOLUTION_CACHE_SIZE);
+    // a solution the display hasn't taken yet (it was still holding the previous one). dropping it would leave the
+    // overlay of the previous board on the new one, since p.solved stops any further OCR.
+    Solution unsent;
+    bool has_unsent = false;
+    auto send = [&](Solution &&solution) {
+        has_unsent = !p.solutions.tryPush(std::move(solution)); // tryPush leaves it untouched when full
+        if (has_unsent) unsent = std::move(solution);
+    };
+    while (p.running) {
+        if (has_unsent) send(std::move(unsent));
+        if (p.solved || !p.boards.popLatest(img_sudoku)) {
+            idle();
+            continue;
+        }
+        SudokuBoard sb;
+        int orientation = 0;
+        {
+            ProfileScope scope(profiler, "parse board");
+            parseSudokuBoard(sb, orientation, img_sudoku, classifier, ocr); // this return bool (parsed correctly or not), but we will be using sb.hasBoard()
+        }
 
-            // if coords is not empty, parse the sudokuBoard.
-            if (!coords.empty()) {
-                parseSudokuBoard(sb, img_sudoku); // this return bool (parsed correctly or not), but we will be using sb.hasBoard()
+        if (sb.hasBoard()) {
+            const Solution* cached;
+            {
+                ProfileScope scope(profiler, "solution cache");
+                cached = cache.find(sb.getOriginalGrid());
             }
+            if (cached != nullptr) {
+                Solution solution = *cached;
+                solution.orientation = orientation; // the same puzzle may come back turned
+                p.solved = true;
+                send(std::move(solution));
+                reportProfile("ocr");
+                continue;
+            }
+        }
 
-            // print board TODO: this is for testing, erase later
-            // SudokuBoard::printBoard(sb.getOriginalBoard());
-
+        // a real sudoku has exactly one solution. more than one means OCR missed a digit, none means it misread one,
+        // either way the overlay would be wrong, so look for another frame.
+        if (sb.hasBoard()) {
+            ProfileScope scope(profiler, "uniqueness check");
+            if (!solver.hasUniqueSolution(sb)) sb.setHasBoard(false);
+        }
 
-            if (sb.hasBoard()) { // if it parsed board, solve the answer (notice this will only run once)
+        if (sb.hasBoard()) { // if it parsed board, solve the answer (notice this will only run once)
+            {
+                ProfileScope scope(profiler, "solve");
                 solver.solve(sb); // solve() will set sb.hasBoard() to false if can't solve, bcz that means the board has wrong configuration. It will look for another board.
-                SudokuBoard::printBoard(sb.getSolvedBoard());
-                img_solution = buildSolutionImage(sb);
+            }
+            if (sb.hasBoard()) {
+                SudokuBoard::printBoard(sb.getSolvedGrid());
+                Solution solution{sb, cv::Mat(), orientation};
+                {
+                    ProfileScope scope(profiler, "build solution image");
+                    solution.img_solution = buildSolutionImage(sb);
+                }
+                cache.put(sb.getOriginalGrid(), solution); // img_solution is never drawn into, so sharing it is fine
+                p.solved = true;
+                send(std::move(solution));
             }
         }
+        reportProfile("ocr");
+    }
+}
 
-        if (sb.hasBoard() && !coords.empty()) {
-            warpSolutionImage(coords, img_solution, img_show);
-            printMetrics(sb, img_show);
-        }
-        imshow("camera", img_show);
+int main() {
+    using namespace cv;
+    Pipeline pipeline;
+    HeuristicsBacktrackingSolver solver_backtracking; // change here whatever solver you want to use.
+    SudokuSolver &solver = solver_backtracking;
 
-        // if (waitKey(50) >= 0) break;
-        waitKey(50);
+    // every OCR engine is loaded once, here, and reused for every board
+    std::unique_ptr<OcrEnginePool> ocr;
+    {
+        ProfileScope scope(profiler, "tesseract init");
+        ocr = std::make_unique<OcrEnginePool>();
     }
+    if (!ocr->ok()) return -1;
+    // built-in digit recognizer, tesseract only gets the cells it isn't sure about
+    DigitClassifier classifier;
+    std::cout << "digit classifier kernel: " << classifier.getKernelName() << std::endl;
 
+    VideoCapture cap(0);
+    if (!cap.isOpened()) {
+        std::cerr << "Error: Could not open video capture device." << std::endl;
+        return -1;
+    }
+
+    std::thread capture_thread(captureStage, std::ref(pipeline), std::ref(cap));
+    std::thread detection_thread(detectionStage, std::ref(pipeline));
+    std::thread ocr_thread(ocrStage, std::ref(pipeline), std::ref(solver), std::cref(classifier), std::ref(*ocr));
+
+    // display stays on the main thread: HighGUI windows must be driven from it.
+    Detection d;
+    Solution solution;
+    bool has_solution = false;
+    while (pipeline.running) {
+        if (pipeline.solutions.popLatest(solution)) {
+            has_solution = true;
+            imshow("Solution Image", solution.img_solution);
+        }
+        if (!pipeline.solved) has_solution = false; // the board it belonged to is gone
+        if (!pipeline.detected.popLatest(d)) {
+            waitKey(1); // keeps the windows responsive
+            continue;
+        }
+
+        {
+            ProfileScope frame(profiler, "display");
+            if (!d.img_sudoku.empty()) imshow("Sudoku Board Warped", d.img_sudoku);
+
+            // the last known solution, on the newest corners
+            if (has_solution && !d.coords.empty()) {
+                {
+                    ProfileScope scope(profiler, "overlay solution");
+                    warpSolutionImage(turnCorners(d.coords, solution.orientation), solution.img_solution, d.img_show);
+                }
+                printMetrics(solution.sb, d.img_show);
+            }
+            printProfile(d.img_show, {
+                "dropped frames: detection " + to_string(pipeline.captured.droppedCount()) +
+                ", display " + to_string(pipeline.detected.droppedCount()) +
+                ", ocr " + to_string(pipeline.boards.droppedCount()),
+                std::string("board: ") + (d.coords.empty() ? "none" : d.tracked ? "tracked" : "detected")
+            });
+            {
+                ProfileScope scope(profiler, "imshow");
+                imshow("camera", d.img_show);
+                waitKey(1);
+            }
+        }
+        // after the frame scope is closed, so printing isn't counted in the stage it reports
+        reportProfile("display");
+    }
 
+    pipeline.running = false;
+    capture_thread.join();
+    detection_thread.join();
+    ocr_thread.join();
     return 0;
 }
 #endif
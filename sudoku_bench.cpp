@@ -0,0 +1,143 @@
+// Corpus driven benchmark: runs every registered SudokuSolver over a file of puzzles and reports throughput and
+// latency percentiles. Needs neither OpenCV nor Tesseract.
+//
+// usage: sudoku_bench <corpus> [-s solver]... [-r repeats] [-n max_puzzles] [-v]
+//
+// -v uses the solvers built with CollectStats and prints their search statistics summed over the corpus.
+// timings are then of the instrumented solvers.
+//
+// the corpus has one puzzle per line, 81 characters ('1'-'9', '.' or '0' for empty), anything after that is ignored.
+// empty lines and lines starting with '#' are skipped.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "SolverRegistry.h"
+#include "SudokuBoard.h"
+#include "Timer.h"
+
+using namespace std;
+
+struct BenchResult {
+    size_t solves = 0;
+    size_t failed = 0;
+    double total = 0;                // seconds spent in solve()
+    vector<double> latencies;        // seconds, one per solve
+    SolveStats stats;                // summed over every solve (all zero unless the solver collects stats)
+};
+
+static vector<Grid> readCorpus(const string &path, size_t maxPuzzles, size_t &badLines) {
+    vector<Grid> puzzles;
+    ifstream in(path);
+    string line;
+    badLines = 0;
+    while (puzzles.size() < maxPuzzles && getline(in, line)) {
+        if (line.empty() || line[0] == '#' || line == "\r") continue;
+        Grid g;
+        if (SudokuBoard::fromString(line, g)) puzzles.push_back(g);
+        else badLines++;
+    }
+    return puzzles;
+}
+
+static BenchResult run(SudokuSolver &solver, const vector<Grid> &puzzles, int repeats) {
+    BenchResult r;
+    r.latencies.reserve(puzzles.size() * repeats);
+    for (int rep = 0; rep < repeats; rep++) {
+        for (const Grid &p : puzzles) {
+            SudokuBoard sb(p);
+            Timer t;
+            solver.solve(sb);
+            double elapsed = t.end();
+
+            r.latencies.push_back(elapsed);
+            r.total += elapsed;
+            r.solves++;
+            if (!sb.hasBoard() || !sb.getSolvedStatus() || !SudokuBoard::isValidSolution(p, sb.getSolvedGrid()))
+                r.failed++;
+            r.stats += sb.getStats();
+        }
+    }
+    return r;
+}
+
+// nearest rank percentile of sorted values, p in [0, 100]
+static double percentile(const vector<double> &sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t rank = (size_t) (p / 100.0 * sorted.size() + 0.5);
+    rank = min(max<size_t>(rank, 1), sorted.size());
+    return sorted[rank - 1];
+}
+
+static void usage() {
+    fprintf(stderr, "usage: sudoku_bench <corpus> [-s solver]... [-r repeats] [-n max_puzzles] [-v]\nsolvers:");
+    for (const SolverInfo &info : registeredSolvers()) fprintf(stderr, " %s", info.name);
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv) {
+    string corpus;
+    vector<string> names;
+    int repeats = 1;
+    size_t maxPuzzles = (size_t) -1;
+    bool withStats = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-s") && i + 1 < argc) names.push_back(argv[++i]);
+        else if (!strcmp(argv[i], "-r") && i + 1 < argc) repeats = max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc) maxPuzzles = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "-v")) withStats = true;
+        else if (argv[i][0] != '-' && corpus.empty()) corpus = argv[i];
+        else {
+            usage();
+            return 2;
+        }
+    }
+    if (corpus.empty()) {
+        usage();
+        return 2;
+    }
+    if (names.empty()) {
+        for (const SolverInfo &info : registeredSolvers()) names.push_back(info.name);
+    }
+
+    size_t badLines;
+    vector<Grid> puzzles = readCorpus(corpus, maxPuzzles, badLines);
+    if (puzzles.empty()) {
+        fprintf(stderr, "no puzzles read from %s\n", corpus.c_str());
+        return 2;
+    }
+    printf("corpus: %s, %zu puzzles", corpus.c_str(), puzzles.size());
+    if (badLines) printf(" (%zu unparsable lines skipped)", badLines);
+    printf(", %d repeat(s)\n\n", repeats);
+
+    printf("%-20s %12s %11s %11s %11s %11s %8s\n", "solver", "puzzles/s", "mean us", "median us", "p99 us", "max us", "failed");
+    bool anyFailed = false;
+    for (const string &name : names) {
+        unique_ptr<SudokuSolver> solver = makeSolver(name, withStats);
+        if (!solver) {
+            fprintf(stderr, "unknown solver: %s\n", name.c_str());
+            usage();
+            return 2;
+        }
+        BenchResult r = run(*solver, puzzles, repeats);
+        sort(r.latencies.begin(), r.latencies.end());
+        printf("%-20s %12.1f %11.2f %11.2f %11.2f %11.2f %8zu\n", name.c_str(),
+               r.total > 0 ? r.solves / r.total : 0,
+               r.total / r.solves * 1e6,
+               percentile(r.latencies, 50) * 1e6,
+               percentile(r.latencies, 99) * 1e6,
+               r.latencies.back() * 1e6,
+               r.failed);
+        if (withStats) r.stats.print(cout);
+        fflush(stdout);
+        if (r.failed) anyFailed = true;
+    }
+    return anyFailed ? 1 : 0;
+}
@@ -0,0 +1,398 @@
+// Headless batch solver: streams puzzles from a file (memory-mapped) or stdin, solves them on several threads and
+// writes the solutions to stdout in input order. Needs neither OpenCV nor Tesseract.
+//
+// usage: sudoku_cli [file] [-s solver] [-t threads] [-b batch_size] [-n box_size] [-c limit] [-v]
+//
+// input: one puzzle per line, 81 characters ('1'-'9', '.' or '0' for empty), anything after that is ignored.
+//        empty lines and lines starting with '#' are skipped. without a file (or with "-") stdin is read.
+// output: one line per puzzle, the 81 digit solution, "no solution", or "invalid input" for unparsable lines.
+// -t 0 (default) uses one thread per core, more than the core count is rejected. -v prints throughput to stderr.
+// -n 2, 4 or 5 reads 4x4, 16x16 or 25x25 puzzles instead (N*N characters, 'A'.. for 10.., see BoardShape.h). those are
+// solved with SizedSolver, -s is ignored.
+// -c counts the solutions of every 9x9 puzzle instead of solving it, up to `limit` (0 = all of them), one count per
+// line. each puzzle is counted by SolutionEnumerator on -t threads. with -v every count is also checked against the
+// -s solver's countSolutions (exit code 1 on a mismatch), and the work stealing totals are printed.
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "BoardShape.h"
+#include "SizedSolver.h"
+#include "SolutionEnumerator.h"
+#include "SolverRegistry.h"
+#include "SudokuBoard.h"
+#include "SudokuSolver.h"
+#include "Timer.h"
+
+using namespace std;
+
+// gives the input one line at a time, from a memory-mapped file or from a file descriptor read in big chunks.
+class LineReader {
+    static constexpr size_t CHUNK = 1 << 20;
+
+    int fd = -1;
+    bool ownsFd = false;
+    // mapped file
+    const char *map = nullptr;
+    size_t mapSize = 0, pos = 0;
+    // streamed input: buf[begin, end) is unread
+    vector<char> buf;
+    size_t begin = 0, end = 0;
+    bool eof = false;
+
+public:
+    // path "-" reads stdin. files that can't be mapped (pipes, /dev/stdin...) are streamed too.
+    bool open(const string &path) {
+        if (path == "-") {
+            fd = STDIN_FILENO;
+            return true;
+        }
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        ownsFd = true;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                map = (const char *) p;
+                mapSize = st.st_size;
+                madvise(p, mapSize, MADV_SEQUENTIAL);
+            }
+        }
+        return true;
+    }
+
+    ~LineReader() {
+        if (map) munmap((void *) map, mapSize);
+        if (ownsFd) close(fd);
+    }
+
+    /**
+     * next line without its '\n'. the pointer stays valid until the next call.
+     * @return false at the end of the input
+     */
+    bool next(const char *&line, size_t &len) {
+        if (map) {
+            if (pos >= mapSize) return false;
+            const char *start = map + pos;
+            const char *nl = (const char *) memchr(start, '\n', mapSize - pos);
+            len = nl ? nl - start : mapSize - pos;
+            pos += len + 1;
+            line = start;
+            return true;
+        }
+        while (true) {
+            const char *start = buf.data() + begin;
+            // buf is empty (data() may be null) until the first read
+            const char *nl = end > begin ? (const char *) memchr(start, '\n', end - begin) : nullptr;
+            if (nl || (eof && end > begin)) {
+                len = nl ? nl - start : end - begin;
+                begin += nl ? len + 1 : len;
+                line = start;
+                return true;
+            }
+            if (eof) return false;
+            // keep the partial line, and read more after it
+            if (end > begin) memmove(buf.data(), start, end - begin);
+            end -= begin;
+            begin = 0;
+            if (buf.size() < end + CHUNK) buf.resize(end + CHUNK);
+            ssize_t n = read(fd, buf.data() + end, CHUNK);
+            if (n <= 0) eof = true;
+            else end += n;
+        }
+    }
+};
+
+// writes everything in `out` to stdout with as few write calls as possible.
+static bool writeAll(const string &out) {
+    size_t done = 0;
+    while (done < out.size()) {
+        ssize_t n = write(STDOUT_FILENO, out.data() + done, out.size() - done);
+        if (n <= 0) return false;
+        done += n;
+    }
+    return true;
+}
+
+// what a run did, for -v
+struct CliTotals {
+    size_t total = 0, solved = 0, invalid = 0;
+    size_t mismatched = 0;  // -c -v: counts the -s solver disagrees with
+};
+
+/**
+ * the whole loop for one of the other board sizes: same batching and output as 9x9, but the batch is split between
+ * threads here, each with its own SizedSolver (SudokuSolver::solveBatch only knows 9x9 boards).
+ * @return false on a write error
+ */
+template <int BOX>
+static bool runSized(LineReader &in, const unsigned &threadsWanted, const size_t &batchSize, CliTotals &totals) {
+    using Shape = BoardShape<BOX>;
+    unsigned threads = threadsWanted ? threadsWanted : max(1u, thread::hardware_concurrency());
+    vector<typename Shape::Grid> boards;
+    vector<char> solved;
+    vector<int> slots;
+    string out;
+    vector<char> solution(Shape::CELLS + 1, '\n');
+    bool more = true;
+    while (more) {
+        boards.clear();
+        slots.clear();
+        const char *line;
+        size_t len;
+        while (slots.size() < batchSize && (more = in.next(line, len))) {
+            if (len == 0 || line[0] == '#' || (len == 1 && line[0] == '\r')) continue;
+            typename Shape::Grid g;
+            if (Shape::fromString(line, len, g)) {
+                slots.push_back((int) boards.size());
+                boards.push_back(g);
+            } else {
+                slots.push_back(-1);
+            }
+        }
+        if (slots.empty()) break;
+
+        solved.assign(boards.size(), 0);
+        atomic<size_t> next{0};
+        auto work = [&]() {
+            SizedSolver<BOX> solver;
+            for (size_t i; (i = next.fetch_add(1, memory_order_relaxed)) < boards.size();) {
+                solved[i] = solver.solve(boards[i]);
+            }
+        };
+        vector<thread> pool;
+        for (unsigned i = 1; i < min<size_t>(threads, boards.size()); i++) pool.emplace_back(work);
+        work();
+        for (thread &th : pool) th.join();
+
+        out.clear();
+        for (int slot : slots) {
+            totals.total++;
+            if (slot < 0) {
+                out += "invalid input\n";
+                totals.invalid++;
+            } else if (solved[slot]) {
+                Shape::toString(boards[slot], solution.data());
+                out.append(solution.data(), solution.size());
+                totals.solved++;
+            } else {
+                out += "no solution\n";
+            }
+        }
+        if (!writeAll(out)) return false;
+    }
+    return true;
+}
+
+/**
+ * the whole loop for 9x9 boards: parse up to batchSize lines, solve them with SudokuSolver::solveBatch, write them
+ * in input order.
+ * @return false on a write error
+ */
+static bool runBoards(LineReader &in, SudokuSolver &solver, const unsigned &threads, const size_t &batchSize,
+                      CliTotals &totals) {
+    SudokuBoardBatch boards;
+    vector<int> slots;  // per input line: index in boards, or -1 if the line didn't parse
+    string out;
+    boards.reserve(batchSize);
+    slots.reserve(batchSize);
+    out.reserve(batchSize * 82);
+
+    bool more = true;
+    while (more) {
+        boards.clear();
+        slots.clear();
+        const char *line;
+        size_t len;
+        while (slots.size() < batchSize && (more = in.next(line, len))) {
+            if (len == 0 || line[0] == '#' || (len == 1 && line[0] == '\r')) continue;
+            Grid g;
+            if (SudokuBoard::fromString(line, len, g)) {
+                slots.push_back((int) boards.size());
+                boards.emplace_back(g);
+            } else {
+                slots.push_back(-1);
+            }
+        }
+        if (slots.empty()) break;
+
+        BatchStats stats = solver.solveBatch(boards, threads);
+        totals.total += slots.size();
+        totals.solved += stats.solved;
+
+        out.clear();
+        char solution[82];
+        solution[81] = '\n';
+        for (int slot : slots) {
+            if (slot < 0) {
+                out += "invalid input\n";
+                totals.invalid++;
+            } else if (boards[slot].hasBoard() && boards[slot].getSolvedStatus()) {
+                SudokuBoard::toString(boards[slot].getSolvedGrid(), solution);
+                out.append(solution, 82);
+            } else {
+                out += "no solution\n";
+            }
+        }
+        if (!writeAll(out)) return false;
+    }
+
+    return true;
+}
+
+/**
+ * the loop for -c: one SolutionEnumerator count per 9x9 puzzle, written as one line each, batchSize lines per write.
+ * @param check with verbose, the solver every count is checked against
+ * @return false on a write error
+ */
+static bool runCounts(LineReader &in, SudokuSolver &check, const unsigned &threads, const size_t &batchSize,
+                      const long long &limit, const bool &verbose, CliTotals &totals) {
+    SolutionEnumerator enumerator(threads);
+    SolutionEnumerator::Result sums;
+    string out;
+    const char *line;
+    size_t len;
+    size_t lines = 0;
+    while (in.next(line, len)) {
+        if (len == 0 || line[0] == '#' || (len == 1 && line[0] == '\r')) continue;
+        totals.total++;
+        Grid g;
+        if (!SudokuBoard::fromString(line, len, g)) {
+            out += "invalid input\n";
+            totals.invalid++;
+        } else {
+            SolutionEnumerator::Result r = enumerator.count(g, limit);
+            if (r.solutions > 0) totals.solved++;
+            out += to_string(r.solutions) + "\n";
+            sums.tasks += r.tasks;
+            sums.steals += r.steals;
+            sums.seconds += r.seconds;
+            if (verbose && check.countSolutions(SudokuBoard(g), limit) != r.solutions) {
+                fprintf(stderr, "count mismatch: %.81s\n", line);
+                totals.mismatched++;
+            }
+        }
+        if (++lines % batchSize == 0) {
+            if (!writeAll(out)) return false;
+            out.clear();
+        }
+    }
+    if (verbose) {
+        fprintf(stderr, "counting: %.3f seconds on %u threads, %lld tasks, %lld steals\n", sums.seconds,
+                enumerator.getThreads(), sums.tasks, sums.steals);
+    }
+    return writeAll(out);
+}
+
+// parses a whole decimal argument. false if it isn't one, or is outside [lo, hi].
+static bool parseNumber(const char *s, const long long &lo, const long long &hi, long long &out) {
+    char *rest;
+    errno = 0;
+    long long v = strtoll(s, &rest, 10);
+    if (rest == s || *rest != '\0' || errno != 0 || v < lo || v > hi) return false;
+    out = v;
+    return true;
+}
+
+static void usage() {
+    fprintf(stderr, "usage: sudoku_cli [file] [-s solver] [-t threads] [-b batch_size] [-n box_size] [-c limit] [-v]\n"
+                    "solvers:");
+    for (const SolverInfo &info : registeredSolvers()) fprintf(stderr, " %s", info.name);
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv) {
+    string path = "-", solverName = "dlx";
+    unsigned threads = 0;
+    size_t batchSize = 4096;
+    int box = 3;
+    long long countLimit = -1;  // -1: solve, don't count
+    bool verbose = false;
+
+    // more threads than cores only adds switching, and a typo like -t -1 must not ask for 4 billion of them
+    const long long maxThreads = max(1u, thread::hardware_concurrency());
+    for (int i = 1; i < argc; i++) {
+        long long value;
+        bool valid = true;
+        if (!strcmp(argv[i], "-s") && i + 1 < argc) solverName = argv[++i];
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+            if ((valid = parseNumber(argv[++i], 0, maxThreads, value))) threads = (unsigned) value;
+        }
+        else if (!strcmp(argv[i], "-b") && i + 1 < argc) {
+            if ((valid = parseNumber(argv[++i], 1, 1 << 24, value))) batchSize = (size_t) value;
+        }
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            if ((valid = parseNumber(argv[++i], 2, 5, value))) box = (int) value;
+        }
+        else if (!strcmp(argv[i], "-c") && i + 1 < argc) {
+            if ((valid = parseNumber(argv[++i], 0, LLONG_MAX, value))) countLimit = value == 0 ? LLONG_MAX : value;
+        }
+        else if (!strcmp(argv[i], "-v")) verbose = true;
+        else if (argv[i][0] != '-' || !strcmp(argv[i], "-")) path = argv[i];
+        else valid = false;
+        if (!valid) {
+            fprintf(stderr, "bad argument: %s (-t 0..%lld, -n 2..5, -b and -c positive, -c 0 = all)\n", argv[i],
+                    maxThreads);
+            usage();
+            return 2;
+        }
+    }
+
+    unique_ptr<SudokuSolver> solver = makeSolver(solverName);
+    if (!solver) {
+        fprintf(stderr, "unknown solver: %s\n", solverName.c_str());
+        usage();
+        return 2;
+    }
+    if (countLimit > 0 && box != 3) {
+        fprintf(stderr, "-c only counts 9x9 puzzles\n");
+        return 2;
+    }
+    LineReader in;
+    if (!in.open(path)) {
+        fprintf(stderr, "can't open %s\n", path.c_str());
+        return 2;
+    }
+
+    Timer t;
+    CliTotals totals;
+    bool written;
+    if (countLimit > 0) written = runCounts(in, *solver, threads, batchSize, countLimit, verbose, totals);
+    else switch (box) {
+        case 2: written = runSized<2>(in, threads, batchSize, totals); break;
+        case 4: written = runSized<4>(in, threads, batchSize, totals); break;
+        case 5: written = runSized<5>(in, threads, batchSize, totals); break;
+        default: written = runBoards(in, *solver, threads, batchSize, totals); break;
+    }
+    if (!written) {
+        fprintf(stderr, "write error\n");
+        return 1;
+    }
+
+    if (verbose && countLimit > 0) {
+        fprintf(stderr, "%zu puzzles (%zu with a solution, %zu invalid, %zu count mismatches) in %.3f seconds\n",
+                totals.total, totals.solved, totals.invalid, totals.mismatched, t.end());
+        return totals.mismatched ? 1 : 0;
+    }
+    if (verbose) {
+        double seconds = t.end();
+        size_t unsolvable = totals.total - totals.solved - totals.invalid;
+        fprintf(stderr, "%zu puzzles (%zu solved, %zu unsolvable, %zu invalid) in %.3f seconds: %.1f puzzles/sec\n",
+                totals.total, totals.solved, unsolvable, totals.invalid, seconds, seconds > 0 ? totals.total / seconds : 0);
+    }
+    return 0;
+}